@@ -41,6 +41,9 @@ fn embedShaderCode(
     const compile = b.addSystemCommand(&.{compiler_path});
     compile.addArgs(&.{
         "--target-env=vulkan1.3",
+        // SPIR-V as a C initializer list, included by the sources that
+        // create pipelines (e.g. `#include "quad.vert.inc"`).
+        "-mfmt=c",
     });
     switch (optimize) {
         .ReleaseFast => compile.addArgs(&.{"-O"}),
@@ -48,14 +51,30 @@ fn embedShaderCode(
     }
 
     compile.addFileArg(src);
+    compile.addArg("-o");
 
-    const path = b.pathJoin("shaders/{s}", .{name});
-    _ = b.addInstallFile(
-        compile.addOutputFileArg(b.fmt("{s}.spv", .{name})),
-        path,
-    );
+    const output = compile.addOutputFileArg(b.fmt("{s}.inc", .{name}));
+    mod.addIncludePath(output.dirname());
+}
 
-    _ = mod;
+fn linkVulkan(
+    mod: *std.Build.Module,
+    vulkan_sdk_path: []const u8,
+    target: std.Build.ResolvedTarget,
+) void {
+    const b = mod.owner;
+    mod.addLibraryPath(.{
+        .cwd_relative = b.pathJoin(&.{ vulkan_sdk_path, "Lib" }),
+    });
+
+    switch (target.result.os.tag) {
+        .windows => {
+            mod.linkSystemLibrary("vulkan-1", .{});
+        },
+        else => {
+            mod.linkSystemLibrary("vulkan", .{});
+        }
+    }
 }
 
 pub fn build(b: *std.Build) void {
@@ -78,6 +97,22 @@ pub fn build(b: *std.Build) void {
         .files = &.{
             "src/core/window.cpp",
             "src/core/graphics.cpp",
+            "src/core/rendergraph.cpp",
+            "src/core/spritebatch.cpp",
+            "src/core/pipelines.cpp",
+            "src/core/textures.cpp",
+            "src/core/truetype.cpp",
+            "src/core/text.cpp",
+            "src/core/blocks.cpp",
+            "src/core/software.cpp",
+            "src/core/thread.cpp",
+            "src/core/jobs.cpp",
+            "src/core/timer.cpp",
+            "src/core/capture.cpp",
+            "src/core/watch.cpp",
+            "src/core/startup.cpp",
+
+            "src/arena.cpp",
 
             "src/engine.cpp",
             "src/window.cpp",
@@ -110,22 +145,30 @@ pub fn build(b: *std.Build) void {
         .cwd_relative = b.pathJoin(&.{ vulkan_sdk_path, "Include" }),
     });
 
-    // embedShaderCode(
-    //     b,
-    //     vulkan_sdk_path,
-    //     igfx_lib_mod,
-    //     b.path("shaders/quad.frag"),
-    //     "quad.frag",
-    //     target,
-    //     optimize,
-    // );
+    for ([_][]const u8{ "quad.vert", "quad.frag" }) |shader| {
+        embedShaderCode(
+            b,
+            vulkan_sdk_path,
+            lib_mod,
+            b.path(b.fmt("shaders/{s}", .{shader})),
+            shader,
+            target,
+            optimize,
+        );
+    }
 
     const glfw = b.dependency("glfw", .{ .target = target, .optimize = optimize });
     lib_mod.linkLibrary(glfw.artifact("glfw3"));
 
+    // Debug builds share the engine as a dynamic library, so the hot
+    // reloaded user library and the executable use one copy of its state
+    // (window, device, loaded textures) instead of each linking their own.
+    if (optimize == .Debug) linkVulkan(lib_mod, vulkan_sdk_path, target);
+
     const lib = b.addLibrary(.{
         .name = "igfx",
         .root_module = lib_mod,
+        .linkage = if (optimize == .Debug) .dynamic else .static,
     });
 
     b.installArtifact(lib);
@@ -145,18 +188,7 @@ pub fn build(b: *std.Build) void {
     wrapper_mod.linkLibrary(lib);
     wrapper_mod.linkLibrary(libcx);
 
-    wrapper_mod.addLibraryPath(.{
-        .cwd_relative = b.pathJoin(&.{ vulkan_sdk_path, "Lib" }),
-    });
-
-    switch (target.result.os.tag) {
-        .windows => {
-            wrapper_mod.linkSystemLibrary("vulkan-1", .{});
-        },
-        else => {
-            wrapper_mod.linkSystemLibrary("vulkan", .{});
-        }
-    }
+    linkVulkan(wrapper_mod, vulkan_sdk_path, target);
 
     const user_mod = b.createModule(.{
         .target = target,
@@ -183,9 +215,14 @@ pub fn build(b: *std.Build) void {
         .root_module = wrapper_mod,
     });
 
-    // Depending on the optimize mode either link statically or
-    // provide a path to the dll enabling hot reload during debugging (TODO).
+    // Depending on the optimize mode either link statically or provide a
+    // path to the dll, which is reloaded whenever it is rebuilt (e.g. by
+    // `zig build --watch` in another terminal) during debugging.
     if (optimize == .Debug) {
+        // libigfx.so is installed to lib/ next to bin/, Windows finds the
+        // DLL in bin/.
+        if (target.result.os.tag != .windows) wrapper_mod.addRPathSpecial("$ORIGIN/../lib");
+
         const user_install = b.addInstallArtifact(user_lib, .{});
         const user_install_path = b.pathJoin(&.{
             b.install_path,
@@ -201,9 +238,129 @@ pub fn build(b: *std.Build) void {
 
     b.installArtifact(exe);
 
+    // Textures are baked on the host into block compressed mip chains,
+    // loaded at runtime with `loadSprite("textures/<name>.igtex")`.
+    const texture_format = b.option(
+        []const u8,
+        "texture-format",
+        "Format textures are baked to (bc7, bc3 or rgba8)",
+    ) orelse "bc7";
+
+    const host_libcx = b.dependency("libcx", .{
+        .target = b.graph.host,
+        .optimize = .ReleaseFast,
+    }).artifact("libcx");
+
+    const bake_mod = b.createModule(.{
+        .target = b.graph.host,
+        .optimize = .ReleaseFast,
+    });
+
+    bake_mod.addCSourceFiles(.{
+        .files = &.{
+            "src/bake.cpp",
+            "src/core/blocks.cpp",
+        },
+        .flags = cpp_flags,
+    });
+
+    bake_mod.addIncludePath(b.path("include"));
+    bake_mod.addIncludePath(b.path("src"));
+    bake_mod.linkLibrary(host_libcx);
+
+    const bake = b.addExecutable(.{
+        .name = "bake",
+        .root_module = bake_mod,
+    });
+
+    if (b.build_root.handle.openDir("example/textures", .{ .iterate = true })) |dir_const| {
+        var dir = dir_const;
+        defer dir.close();
+
+        var it = dir.iterate();
+        while (it.next() catch null) |entry| {
+            if (entry.kind != .file or !mem.endsWith(u8, entry.name, ".tga")) continue;
+
+            const stem = fs.path.stem(entry.name);
+            const bake_cmd = b.addRunArtifact(bake);
+            bake_cmd.addFileArg(b.path(b.fmt("example/textures/{s}", .{entry.name})));
+            const baked = bake_cmd.addOutputFileArg(b.fmt("{s}.igtex", .{stem}));
+            bake_cmd.addArg(texture_format);
+
+            b.getInstallStep().dependOn(&b.addInstallFileWithDir(
+                baked,
+                .bin,
+                b.fmt("textures/{s}.igtex", .{stem}),
+            ).step);
+        }
+    } else |_| {}
+
     const run_cmd = b.addRunArtifact(exe);
     run_cmd.step.dependOn(b.getInstallStep());
+    // Baked textures are installed next to the executable.
+    run_cmd.setCwd(.{ .cwd_relative = b.getInstallPath(.bin, "") });
 
     const run_step = b.step("run", "Run the example app");
     run_step.dependOn(&run_cmd.step);
+
+    // Replays a frame capture (IGFX_CAPTURE) without the user library.
+    const replay_mod = b.createModule(.{
+        .target = target,
+        .optimize = optimize,
+    });
+
+    replay_mod.addCSourceFiles(.{
+        .files = &.{"src/replay.cpp"},
+        .flags = cpp_flags,
+    });
+
+    replay_mod.addIncludePath(b.path("include"));
+    replay_mod.addIncludePath(b.path("src"));
+    replay_mod.linkLibrary(lib);
+    replay_mod.linkLibrary(libcx);
+    linkVulkan(replay_mod, vulkan_sdk_path, target);
+    if (optimize == .Debug and target.result.os.tag != .windows) {
+        replay_mod.addRPathSpecial("$ORIGIN/../lib");
+    }
+
+    const replay = b.addExecutable(.{
+        .name = "replay",
+        .root_module = replay_mod,
+    });
+
+    b.installArtifact(replay);
+
+    const replay_cmd = b.addRunArtifact(replay);
+    replay_cmd.step.dependOn(b.getInstallStep());
+    if (b.args) |args| replay_cmd.addArgs(args);
+
+    const replay_step = b.step("replay", "Replay a frame capture (zig build replay -- <capture>)");
+    replay_step.dependOn(&replay_cmd.step);
+
+    // Engine tests, headless so they run without a GPU.
+    const test_step = b.step("test", "Run the engine tests");
+    for ([_][]const u8{ "software", "rendergraph" }) |name| {
+        const test_mod = b.createModule(.{
+            .target = target,
+            .optimize = optimize,
+        });
+
+        test_mod.addCSourceFiles(.{
+            .files = &.{b.fmt("tests/{s}.cpp", .{name})},
+            .flags = cpp_flags,
+        });
+
+        test_mod.addIncludePath(b.path("include"));
+        test_mod.addIncludePath(b.path("src"));
+        test_mod.linkLibrary(lib);
+        test_mod.linkLibrary(libcx);
+        linkVulkan(test_mod, vulkan_sdk_path, target);
+
+        const test_exe = b.addExecutable(.{
+            .name = b.fmt("test-{s}", .{name}),
+            .root_module = test_mod,
+        });
+
+        test_step.dependOn(&b.addRunArtifact(test_exe).step);
+    }
 }
@@ -0,0 +1,66 @@
+#pragma once
+#include <std/nums.h>
+
+namespace igfx {
+    enum class Backend : u8 {
+        // Vulkan when a suitable GPU is found, software otherwise.
+        Auto,
+        Vulkan,
+        // Tiled multi-threaded CPU rasterizer rendering into a host
+        // framebuffer, runs headless (no window).
+        Software,
+    };
+
+    enum class PresentMode : u8 {
+        // Vsync, never tears.
+        Fifo,
+        // Vsync, tears when a frame is late instead of waiting a refresh.
+        FifoRelaxed,
+        // Vsync without blocking, newer frames replace queued ones.
+        Mailbox,
+        // No vsync, tears.
+        Immediate,
+    };
+
+    // Filled in by the optional `extern "C" void configure(igfx::Config*)`
+    // before the engine initializes.
+    struct Config {
+        Backend backend = Backend::Auto;
+        u32 width = 640;
+        u32 height = 480;
+        u8 const* title = "";
+
+        // Falls back to Fifo (always supported) when unavailable.
+        PresentMode presentMode = PresentMode::Mailbox;
+        // 0 picks the surface minimum + 1, otherwise clamped to what the
+        // surface supports.
+        u32 swapchainImageCount = 0;
+        // Upper bound on VRAM used by textures in bytes, 0 uses what
+        // VK_EXT_memory_budget reports as available (or 80% of the device
+        // local heap without it).
+        u64 textureBudget = 0;
+        // With a Fifo mode and VK_KHR_present_wait, delays input sampling and
+        // `update` until just before the next frame is needed.
+        bool lowLatency = false;
+
+        // Records every frame into this file for `replay`, also set through
+        // the IGFX_CAPTURE environment variable.
+        u8 const* capturePath = nullptr;
+
+        // Runs `update` and `draw` on a simulation thread that records up to
+        // `pipelineDepth - 1` frames ahead while the main thread renders.
+        // Only what `draw` records into the `Frame` crosses threads, user
+        // state is never touched by the render thread.
+        bool pipelined = false;
+        u32 pipelineDepth = 2; // 2 (double) or 3 (triple buffered)
+
+        // Draws sprites into an offscreen target whose resolution follows
+        // the measured GPU frame time, kept under `frameBudget` between the
+        // render scale bounds, and upscales it to the window. Text is drawn
+        // on top at native resolution. Vulkan backend only.
+        bool dynamicResolution = false;
+        f32 frameBudget = 1.0f / 60.0f; // seconds of GPU time
+        f32 minRenderScale = 0.5f;
+        f32 maxRenderScale = 1.0f; // up to 2 (supersampling)
+    };
+}
@@ -1,3 +1,4 @@
+#pragma once
 #include <std/nums.h>
 
 namespace igfx {
@@ -5,13 +6,112 @@ namespace igfx {
         u32 index = 0;
     };
 
+    enum class BlendMode : u8 {
+        // Source over, by the sprite's alpha.
+        Alpha,
+        // Adds the sprite's color weighted by its alpha (glows, particles).
+        Additive,
+        // Multiplies by the sprite's color, faded to white by its alpha
+        // (shadows, tinting).
+        Multiply,
+    };
+
+    constexpr u32 blendModeCount = 3;
+
     struct DrawSpriteOptions {
         vec2 position;
         vec2 scale;
+        // Radians around the sprite center, clockwise on screen.
+        f32 rotation = 0.0f;
+        BlendMode blend = BlendMode::Alpha;
+    };
+
+    struct Font {
+        u32 index = 0;
+    };
+
+    struct DrawTextOptions {
+        vec2 position; // top left of the first line
+        f32 size = 16.0f; // pixels per em
+        u32 color = 0xffffffff; // RGBA8, R in the low byte (0xAABBGGRR)
     };
 
     struct Frame {
         u32 index;
         void DrawSprite(Sprite, DrawSpriteOptions);
+        // UTF-8, '\n' starts a new line. Glyphs are rasterized the first
+        // time they are drawn and a string's layout is cached while it is
+        // drawn unchanged.
+        void DrawText(Font, u8 const* text, DrawTextOptions);
+    };
+
+    struct Image {
+        u32 width;
+        u32 height;
+        u32 const* pixels; // RGBA8, row-major
+    };
+
+    // The last frame rendered by the software backend, empty otherwise.
+    Image framebuffer();
+
+    // Uploads `image` (RGBA8) as a texture and returns a sprite drawing all
+    // of it at its pixel size. Call from `init`. Textures reach VRAM when
+    // first drawn and may be dropped to lower mips when VRAM runs short.
+    Sprite createSprite(Image image);
+
+    // Loads a texture baked by build.zig (`textures/<name>.igtex` next to
+    // the executable) as a sprite. Call from `init`. Block compressed
+    // textures are decoded on load when the device can't sample them.
+    // Loading the same path again returns the same sprite.
+    Sprite loadSprite(u8 const* path);
+
+    // Loads a TrueType font. Call from `init`. Returns the default (empty)
+    // font, which draws nothing, when the file can't be read. Loading the
+    // same path again returns the same font.
+    Font loadFont(u8 const* path);
+
+    // Size of `text`'s bounding box, the line height times the line count
+    // high.
+    vec2 measureText(Font font, u8 const* text, f32 size);
+
+    // Texture residency as of the last frame rendered (Vulkan backend).
+    struct TextureStats {
+        u32 textures;
+        u32 resident; // all mips in VRAM
+        u32 partial;  // dropped to a lower mip
+        u32 evicted;  // not in VRAM, drawn white until streamed back
+        u64 residentBytes;
+        u64 budgetBytes;
+
+        // Changes made during the frame.
+        u32 streamed;
+        u64 streamedBytes;
+        u32 demoted;
+        u32 dropped;
     };
+
+    TextureStats textureStats();
+
+    // Render scale of the last frame (`Config::dynamicResolution`), 1 when
+    // disabled.
+    f32 renderScale();
+
+    // Times are seconds since the engine started initializing.
+    struct StartupPhase {
+        u8 const* name;
+        f32 start;
+        f32 duration; // negative if still running at the first frame
+    };
+
+    // Where startup time went, complete once the first frame is rendered.
+    // Phases on job threads overlap the ones on the main thread.
+    struct StartupReport {
+        static constexpr u32 maxPhases = 32;
+
+        StartupPhase phases[maxPhases];
+        u32 phaseCount;
+        f32 total; // until the first frame
+    };
+
+    StartupReport const& startupReport();
 }
@@ -1,7 +1,12 @@
 #include "igfx/linalg.h"
 
 namespace igfx::window {
+    // Size of the window when the current frame began, in screen
+    // coordinates. Constant for the whole frame.
     u32 width();
     u32 height();
     vec2 size();
+
+    // Ends the main loop after the current frame.
+    void close();
 }
@@ -1,14 +1,35 @@
-#version 430 core
+#version 450 core
 
 layout(location = 0) in vec2 uv;
+layout(location = 1) in vec4 tint;
 
-layout(binding = 0) uniform sampler2D uTexture;
-layout(binding = 1) uniform UBO {
-    vec4 color;
-} ubo;
+layout(set = 1, binding = 0) uniform sampler2D uTexture;
+
+// igfx::BlendMode, set per pipeline.
+layout(constant_id = 0) const uint blendMode = 0;
+const uint blendMultiply = 2;
+
+// The texture is the glyph atlas, a distance field with the edge at 0.5.
+layout(constant_id = 1) const bool sdfText = false;
 
 layout(location = 0) out vec4 fragColor;
 
 void main() {
-  fragColor = texture(uTexture, uv) * ubo.color;
+  vec4 color;
+  if (sdfText) {
+    // Antialiased over about a pixel at any scale.
+    float distance = texture(uTexture, uv).r;
+    float width = max(fwidth(distance) * 0.75, 1.0 / 255.0);
+    color = vec4(tint.rgb, tint.a * smoothstep(0.5 - width, 0.5 + width, distance));
+  } else {
+    color = texture(uTexture, uv) * tint;
+  }
+
+  // Multiply blends by the destination color, fading to white keeps
+  // transparent texels from darkening.
+  if (blendMode == blendMultiply) {
+    color = vec4(mix(vec3(1.0), color.rgb, color.a), color.a);
+  }
+
+  fragColor = color;
 }
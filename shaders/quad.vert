@@ -0,0 +1,72 @@
+#version 450 core
+
+// Sprites are drawn with vertex pulling, six vertices per instance and no
+// vertex buffers. See src/core/spritebatch.h for the packed layouts.
+struct Instance {
+    vec2 position;
+    uint scale;          // f16x2
+    uint rotationSprite; // unorm16 turns | sprite index << 16
+};
+
+struct Sprite {
+    uvec2 uvRect; // unorm16x4 (u0, v0, u1, v1)
+    uint tint;    // RGBA8
+    uint size;    // f16x2 pixels
+};
+
+layout(std430, set = 0, binding = 0) readonly buffer Instances {
+    Instance instances[];
+};
+
+layout(std430, set = 0, binding = 1) readonly buffer Sprites {
+    Sprite sprites[];
+};
+
+layout(push_constant) uniform PushConstants {
+    vec2 viewport;
+} pc;
+
+// Text glyphs: uniform f16 scale, RGBA8 color in place of the rotation.
+layout(constant_id = 1) const bool sdfText = false;
+
+layout(location = 0) out vec2 uv;
+layout(location = 1) out vec4 tint;
+
+const vec2 corners[6] = vec2[](
+    vec2(0.0, 0.0), vec2(1.0, 0.0), vec2(1.0, 1.0),
+    vec2(0.0, 0.0), vec2(1.0, 1.0), vec2(0.0, 1.0)
+);
+
+void main() {
+    Instance instance = instances[gl_InstanceIndex];
+    Sprite sprite = sprites[instance.rotationSprite >> 16];
+    vec2 corner = corners[gl_VertexIndex];
+
+    vec2 scale;
+    float angle;
+    vec4 color;
+    if (sdfText) {
+        scale = vec2(unpackHalf2x16(instance.scale).x);
+        angle = 0.0;
+        color = unpackUnorm4x8((instance.scale >> 16) | (instance.rotationSprite << 16));
+    } else {
+        scale = unpackHalf2x16(instance.scale);
+        angle = float(instance.rotationSprite & 0xffffu) * (6.28318530718 / 65536.0);
+        color = vec4(1.0);
+    }
+
+    vec2 size = unpackHalf2x16(sprite.size) * scale;
+    float c = cos(angle);
+    float s = sin(angle);
+
+    // Rotated around the sprite center, clockwise on screen (y down).
+    vec2 local = (corner - 0.5) * size;
+    vec2 position = instance.position + 0.5 * size 
+        + vec2(c * local.x - s * local.y, s * local.x + c * local.y);
+
+    gl_Position = vec4(position / pc.viewport * 2.0 - 1.0, 0.0, 1.0);
+
+    vec4 rect = vec4(unpackUnorm2x16(sprite.uvRect.x), unpackUnorm2x16(sprite.uvRect.y));
+    uv = mix(rect.xy, rect.zw, corner);
+    tint = unpackUnorm4x8(sprite.tint) * color;
+}
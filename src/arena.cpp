@@ -1,5 +1,4 @@
 #include "arena.h"
-#define PAGE_SIZE 4092
 
 Arena::Arena() {
     this->page = new Arena::Page {
@@ -7,3 +6,29 @@ Arena::Arena() {
         .count = 0,
     };
 }
+
+Arena::~Arena() {
+    while (page != nullptr) {
+        Page* previous = page->previous;
+        delete page;
+        page = previous;
+    }
+}
+
+void Arena::reset() {
+    Page* previous = page->previous;
+    while (previous != nullptr) {
+        Page* next = previous->previous;
+        delete previous;
+        previous = next;
+    }
+
+    page->previous = nullptr;
+    page->count = 0;
+}
+
+usize Arena::size() const {
+    usize bytes = 0;
+    for (Page* p = page; p != nullptr; p = p->previous) bytes += p->count;
+    return bytes;
+}
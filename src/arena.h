@@ -1,5 +1,9 @@
+#pragma once
+
+// Append-only page arena, allocations never move and are released all at
+// once with `reset` or the destructor.
 struct Arena {
-    static constexpr usize pageBytesCount = 4092 - sizeof(usize) * 2;
+    static constexpr usize pageBytesCount = 4096 - sizeof(usize) * 2;
     struct Page {
         Page* previous;
         usize count;
@@ -11,9 +15,31 @@ struct Arena {
     Arena();
     ~Arena();
 
-    // TODO
+    // Frees every page but the current one.
+    void reset();
+
+    // Bytes allocated across all pages.
+    usize size() const;
+
     template <typename T>
     T* alloc(usize count) {
-        return nullptr;
+        static_assert(alignof(T) <= alignof(usize));
+
+        usize bytes = sizeof(T) * count;
+        if (bytes > pageBytesCount) {
+            std::fatal("arena allocation of {} bytes exceeds the page size", bytes);
+        }
+
+        usize offset = (page->count + alignof(T) - 1) & ~(alignof(T) - 1);
+        if (offset + bytes > pageBytesCount) {
+            page = new Page {
+                .previous = page,
+                .count = 0,
+            };
+            offset = 0;
+        }
+
+        page->count = offset + bytes;
+        return (T*)&page->bytes[offset];
     }
 };
@@ -0,0 +1,151 @@
+#include "core/texfile.h"
+#include "core/blocks.h"
+
+#include <std/alloc.h>
+#include <std/mem.h>
+
+#include <stdio.h>
+
+using namespace igfx;
+
+struct Tga {
+    u32 width;
+    u32 height;
+    std::Buf<u32> pixels; // RGBA8, top row first
+};
+
+// Uncompressed (2) and run-length encoded (10) 24/32 bit true color TGA.
+Tga readTga(u8 const* path) {
+    FILE* file = fopen(path, "rb");
+    if (file == nullptr) std::fatal("failed to open '{}'", path);
+    defer { fclose(file); };
+
+    unsigned char header[18];
+    if (fread(header, 1, sizeof(header), file) != sizeof(header)) {
+        std::fatal("'{}' is not a TGA file", path);
+    }
+
+    u32 imageType = header[2];
+    u32 width = header[12] | (header[13] << 8);
+    u32 height = header[14] | (header[15] << 8);
+    u32 bitsPerPixel = header[16];
+    bool topLeft = (header[17] & 0x20) != 0;
+
+    if ((imageType != 2 && imageType != 10) || (bitsPerPixel != 24 && bitsPerPixel != 32)) {
+        std::fatal("'{}': only 24/32 bit true color TGA is supported", path);
+    }
+    if (width == 0 || height == 0) std::fatal("'{}' is empty", path);
+
+    fseek(file, header[0], SEEK_CUR); // image id
+
+    u32 bytesPerPixel = bitsPerPixel / 8;
+    Tga tga {width, height, std::alloc<u32>(width * height)};
+
+    auto readPixel = [&]() -> u32 {
+        unsigned char bgra[4] = {0, 0, 0, 255};
+        if (fread(bgra, 1, bytesPerPixel, file) != bytesPerPixel) {
+            std::fatal("'{}' is truncated", path);
+        }
+
+        return bgra[2] | (bgra[1] << 8) | (bgra[0] << 16) | ((u32)bgra[3] << 24);
+    };
+
+    u32 count = width * height;
+    for (u32 i = 0; i < count;) {
+        u32 run = 1;
+        bool repeat = false;
+        if (imageType == 10) {
+            unsigned char packet;
+            if (fread(&packet, 1, 1, file) != 1) std::fatal("'{}' is truncated", path);
+            run = (packet & 0x7f) + 1;
+            repeat = (packet & 0x80) != 0;
+        }
+
+        u32 pixel = readPixel();
+        for (u32 j = 0; j < run && i < count; j++, i++) {
+            if (j > 0 && !repeat) pixel = readPixel();
+
+            u32 x = i % width;
+            u32 y = topLeft ? i / width : height - 1 - i / width;
+            tga.pixels[y * width + x] = pixel;
+        }
+    }
+
+    return tga;
+}
+
+void encodeLevel(
+    texfile::Format format,
+    u32 const* pixels,
+    u32 width,
+    u32 height,
+    u8* dst
+) {
+    if (format == texfile::Format::RGBA8) {
+        __builtin_memcpy(dst, pixels, (usize)width * height * 4);
+        return;
+    }
+
+    // Edge blocks repeat the last row and column.
+    for (u32 by = 0; by < height; by += 4) {
+        for (u32 bx = 0; bx < width; bx += 4) {
+            u32 texels[16];
+            for (u32 i = 0; i < 16; i++) {
+                u32 x = std::min(bx + i % 4, width - 1);
+                u32 y = std::min(by + i / 4, height - 1);
+                texels[i] = pixels[y * width + x];
+            }
+
+            if (format == texfile::Format::BC7) blocks::encodeBC7(texels, dst);
+            else blocks::encodeBC3(texels, dst);
+            dst += blocks::blockBytes;
+        }
+    }
+}
+
+// Converts a TGA into a baked texture with its full mip chain, run by
+// build.zig for every texture of the application.
+int main(int argc, char** argv) {
+    if (argc < 3) std::fatal("usage: bake <image.tga> <out.igtex> [bc7|bc3|rgba8]");
+
+    texfile::Format format = texfile::Format::BC7;
+    if (argc > 3) {
+        if (std::eqlZ(argv[3], "bc3")) format = texfile::Format::BC3;
+        else if (std::eqlZ(argv[3], "rgba8")) format = texfile::Format::RGBA8;
+        else if (!std::eqlZ(argv[3], "bc7")) std::fatal("unknown format '{}'", argv[3]);
+    }
+
+    Tga tga = readTga(argv[1]);
+    defer { std::free(tga.pixels); };
+
+    texfile::Header header {
+        .version = texfile::version,
+        .format = format,
+        .width = tga.width,
+        .height = tga.height,
+        .mipCount = texfile::mipCount(tga.width, tga.height),
+    };
+    __builtin_memcpy(header.magic, texfile::magic, sizeof(texfile::magic));
+
+    FILE* file = fopen(argv[2], "wb");
+    if (file == nullptr) std::fatal("failed to create '{}'", argv[2]);
+    defer { fclose(file); };
+
+    fwrite(&header, sizeof(header), 1, file);
+
+    auto encoded = std::alloc<u8>(texfile::levelSize(format, tga.width, tga.height));
+    defer { std::free(encoded); };
+
+    // Mips are filtered from the previous level in place.
+    u32 width = tga.width, height = tga.height;
+    for (u32 level = 0; level < header.mipCount; level++) {
+        if (level > 0) {
+            texfile::downsample(tga.pixels.ptr, width, height, tga.pixels.ptr);
+            width = std::max(width / 2, 1u);
+            height = std::max(height / 2, 1u);
+        }
+
+        encodeLevel(format, tga.pixels.ptr, width, height, encoded.ptr);
+        fwrite(encoded.ptr, 1, texfile::levelSize(format, width, height), file);
+    }
+}
@@ -0,0 +1,326 @@
+#include "core/blocks.h"
+
+#include <std/math.h>
+
+namespace igfx::blocks {
+    inline u32 channel(u32 texel, u32 c) {
+        return (texel >> (c * 8)) & 0xff;
+    }
+
+    // u8 is a plain (possibly signed) char.
+    inline u32 byte(u8 value) {
+        return (unsigned char)value;
+    }
+
+    inline u32 rgba(u32 r, u32 g, u32 b, u32 a) {
+        return r | (g << 8) | (b << 16) | (a << 24);
+    }
+
+    // Little endian bit stream over a 128 bit block.
+    struct Bits {
+        u8* bytes;
+        u32 position;
+
+        void write(u32 value, u32 count) {
+            for (u32 i = 0; i < count; i++, position++) {
+                if ((value >> i) & 1) bytes[position / 8] |= 1 << (position % 8);
+            }
+        }
+
+        u32 read(u32 count) {
+            u32 value = 0;
+            for (u32 i = 0; i < count; i++, position++) {
+                value |= ((bytes[position / 8] >> (position % 8)) & 1) << i;
+            }
+
+            return value;
+        }
+    };
+
+    // Endpoints spanning the texels along their principal axis, found by
+    // power iteration on the covariance of the first `channels` channels.
+    void principalEndpoints(u32 const texels[16], u32 channels, f32 lo[4], f32 hi[4]) {
+        f32 mean[4] = {};
+        for (u32 t = 0; t < 16; t++) {
+            for (u32 c = 0; c < channels; c++) mean[c] += channel(texels[t], c) / 16.0f;
+        }
+
+        f32 covariance[4][4] = {};
+        for (u32 t = 0; t < 16; t++) {
+            f32 d[4];
+            for (u32 c = 0; c < channels; c++) d[c] = channel(texels[t], c) - mean[c];
+
+            for (u32 i = 0; i < channels; i++) {
+                for (u32 j = 0; j < channels; j++) covariance[i][j] += d[i] * d[j];
+            }
+        }
+
+        f32 axis[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+        for (u32 iteration = 0; iteration < 8; iteration++) {
+            f32 next[4] = {};
+            f32 largest = 0.0f;
+            for (u32 i = 0; i < channels; i++) {
+                for (u32 j = 0; j < channels; j++) next[i] += covariance[i][j] * axis[j];
+                largest = std::max(largest, __builtin_fabsf(next[i]));
+            }
+
+            // Every texel is the same color.
+            if (largest == 0.0f) {
+                for (u32 c = 0; c < channels; c++) lo[c] = hi[c] = mean[c];
+                return;
+            }
+
+            for (u32 i = 0; i < channels; i++) axis[i] = next[i] / largest;
+        }
+
+        f32 length = 0.0f;
+        for (u32 c = 0; c < channels; c++) length += axis[c] * axis[c];
+        length = __builtin_sqrtf(length);
+
+        f32 minT = 1e30f, maxT = -1e30f;
+        for (u32 t = 0; t < 16; t++) {
+            f32 projection = 0.0f;
+            for (u32 c = 0; c < channels; c++) {
+                projection += (channel(texels[t], c) - mean[c]) * axis[c] / length;
+            }
+
+            minT = std::min(minT, projection);
+            maxT = std::max(maxT, projection);
+        }
+
+        for (u32 c = 0; c < channels; c++) {
+            lo[c] = std::clamp(mean[c] + axis[c] / length * minT, 0.0f, 255.0f);
+            hi[c] = std::clamp(mean[c] + axis[c] / length * maxT, 0.0f, 255.0f);
+        }
+    }
+
+    template <u32 N>
+    inline u32 nearest(u32 texel, u32 const (&palette)[N], u32 channels) {
+        u32 best = 0, bestError = 0xffffffff;
+        for (u32 i = 0; i < N; i++) {
+            u32 error = 0;
+            for (u32 c = 0; c < channels; c++) {
+                i32 d = (i32)channel(texel, c) - (i32)channel(palette[i], c);
+                error += d * d;
+            }
+
+            if (error < bestError) {
+                best = i;
+                bestError = error;
+            }
+        }
+
+        return best;
+    }
+
+    inline u32 expand565(u32 color) {
+        u32 r = (color >> 11) & 0x1f;
+        u32 g = (color >> 5) & 0x3f;
+        u32 b = color & 0x1f;
+        return rgba((r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2), 255);
+    }
+
+    inline u32 quantize565(f32 const color[4]) {
+        u32 r = (u32)(color[0] * 31.0f / 255.0f + 0.5f);
+        u32 g = (u32)(color[1] * 63.0f / 255.0f + 0.5f);
+        u32 b = (u32)(color[2] * 31.0f / 255.0f + 0.5f);
+        return (r << 11) | (g << 5) | b;
+    }
+
+    // BC3 color blocks always use the four color palette.
+    inline void colorPalette(u32 c0, u32 c1, u32 palette[4]) {
+        u32 a = expand565(c0), b = expand565(c1);
+        palette[0] = a;
+        palette[1] = b;
+        palette[2] = 0;
+        palette[3] = 0;
+        for (u32 c = 0; c < 4; c++) {
+            palette[2] |= ((2 * channel(a, c) + channel(b, c)) / 3) << (c * 8);
+            palette[3] |= ((channel(a, c) + 2 * channel(b, c)) / 3) << (c * 8);
+        }
+    }
+
+    inline void alphaPalette(u32 a0, u32 a1, u32 palette[8]) {
+        palette[0] = a0;
+        palette[1] = a1;
+        if (a0 > a1) {
+            for (u32 i = 1; i < 7; i++) palette[i + 1] = ((7 - i) * a0 + i * a1) / 7;
+        } else {
+            for (u32 i = 1; i < 5; i++) palette[i + 1] = ((5 - i) * a0 + i * a1) / 5;
+            palette[6] = 0;
+            palette[7] = 255;
+        }
+    }
+
+    void encodeBC3(u32 const texels[16], u8 block[blockBytes]) {
+        for (u32 i = 0; i < blockBytes; i++) block[i] = 0;
+
+        u32 a0 = 0, a1 = 255;
+        for (u32 t = 0; t < 16; t++) {
+            a0 = std::max(a0, channel(texels[t], 3));
+            a1 = std::min(a1, channel(texels[t], 3));
+        }
+
+        u32 alphas[8];
+        alphaPalette(a0, a1, alphas);
+
+        block[0] = a0;
+        block[1] = a1;
+        Bits alphaBits {block + 2, 0};
+        for (u32 t = 0; t < 16; t++) {
+            u32 best = 0;
+            for (u32 i = 1; i < 8; i++) {
+                i32 a = channel(texels[t], 3);
+                if (__builtin_abs(a - (i32)alphas[i]) < __builtin_abs(a - (i32)alphas[best])) best = i;
+            }
+
+            alphaBits.write(best, 3);
+        }
+
+        f32 lo[4], hi[4];
+        principalEndpoints(texels, 3, lo, hi);
+
+        u32 c0 = quantize565(hi), c1 = quantize565(lo);
+        if (c0 < c1) {
+            u32 swap = c0;
+            c0 = c1;
+            c1 = swap;
+        }
+
+        u32 colors[4];
+        colorPalette(c0, c1, colors);
+
+        block[8] = c0 & 0xff;
+        block[9] = c0 >> 8;
+        block[10] = c1 & 0xff;
+        block[11] = c1 >> 8;
+
+        Bits colorBits {block + 12, 0};
+        for (u32 t = 0; t < 16; t++) {
+            colorBits.write(c0 == c1 ? 0 : nearest(texels[t], colors, 3), 2);
+        }
+    }
+
+    void decodeBC3(u8 const block[blockBytes], u32 texels[16]) {
+        u32 alphas[8];
+        alphaPalette(byte(block[0]), byte(block[1]), alphas);
+
+        u32 colors[4];
+        colorPalette(
+            byte(block[8]) | (byte(block[9]) << 8),
+            byte(block[10]) | (byte(block[11]) << 8),
+            colors
+        );
+
+        Bits alphaBits {(u8*)block + 2, 0};
+        Bits colorBits {(u8*)block + 12, 0};
+        for (u32 t = 0; t < 16; t++) {
+            u32 alpha = alphas[alphaBits.read(3)];
+            texels[t] = (colors[colorBits.read(2)] & 0x00ffffff) | (alpha << 24);
+        }
+    }
+
+    constexpr u32 weights4[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+    // Mode 6 endpoints are 7 bits per channel plus a shared low p-bit.
+    inline void quantize7(f32 const color[4], u32 endpoint[4], u32* pbit) {
+        f32 bestError = 1e30f;
+        for (u32 p = 0; p < 2; p++) {
+            u32 quantized[4];
+            f32 error = 0.0f;
+            for (u32 c = 0; c < 4; c++) {
+                f32 q = (color[c] - p) / 2.0f + 0.5f;
+                quantized[c] = (u32)std::clamp(q, 0.0f, 127.0f);
+
+                f32 d = (f32)(quantized[c] * 2 + p) - color[c];
+                error += d * d;
+            }
+
+            if (error < bestError) {
+                bestError = error;
+                *pbit = p;
+                for (u32 c = 0; c < 4; c++) endpoint[c] = quantized[c];
+            }
+        }
+    }
+
+    inline void mode6Palette(u32 const e0[4], u32 const e1[4], u32 p0, u32 p1, u32 palette[16]) {
+        for (u32 i = 0; i < 16; i++) {
+            palette[i] = 0;
+            for (u32 c = 0; c < 4; c++) {
+                u32 a = (e0[c] << 1) | p0;
+                u32 b = (e1[c] << 1) | p1;
+                u32 value = ((64 - weights4[i]) * a + weights4[i] * b + 32) >> 6;
+                palette[i] |= value << (c * 8);
+            }
+        }
+    }
+
+    void encodeBC7(u32 const texels[16], u8 block[blockBytes]) {
+        for (u32 i = 0; i < blockBytes; i++) block[i] = 0;
+
+        f32 lo[4], hi[4];
+        principalEndpoints(texels, 4, lo, hi);
+
+        u32 e0[4], e1[4], p0, p1;
+        quantize7(lo, e0, &p0);
+        quantize7(hi, e1, &p1);
+
+        u32 palette[16];
+        mode6Palette(e0, e1, p0, p1, palette);
+
+        u32 indices[16];
+        for (u32 t = 0; t < 16; t++) indices[t] = nearest(texels[t], palette, 4);
+
+        // The anchor (texel 0) index is stored without its high bit.
+        if (indices[0] & 8) {
+            for (u32 c = 0; c < 4; c++) {
+                u32 swap = e0[c];
+                e0[c] = e1[c];
+                e1[c] = swap;
+            }
+
+            u32 swap = p0;
+            p0 = p1;
+            p1 = swap;
+
+            for (u32& index : indices) index = 15 - index;
+        }
+
+        Bits bits {block, 0};
+        bits.write(1 << 6, 7);
+        for (u32 c = 0; c < 4; c++) {
+            bits.write(e0[c], 7);
+            bits.write(e1[c], 7);
+        }
+        bits.write(p0, 1);
+        bits.write(p1, 1);
+
+        bits.write(indices[0], 3);
+        for (u32 t = 1; t < 16; t++) bits.write(indices[t], 4);
+    }
+
+    void decodeBC7(u8 const block[blockBytes], u32 texels[16]) {
+        if ((byte(block[0]) & 0x7f) != 0x40) {
+            for (u32 t = 0; t < 16; t++) texels[t] = rgba(255, 0, 255, 255);
+            return;
+        }
+
+        Bits bits {(u8*)block, 7};
+
+        u32 e0[4], e1[4];
+        for (u32 c = 0; c < 4; c++) {
+            e0[c] = bits.read(7);
+            e1[c] = bits.read(7);
+        }
+
+        u32 p0 = bits.read(1);
+        u32 p1 = bits.read(1);
+
+        u32 palette[16];
+        mode6Palette(e0, e1, p0, p1, palette);
+
+        texels[0] = palette[bits.read(3)];
+        for (u32 t = 1; t < 16; t++) texels[t] = palette[bits.read(4)];
+    }
+}
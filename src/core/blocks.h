@@ -0,0 +1,17 @@
+#pragma once
+#include <std/nums.h>
+
+// Block compression of 4x4 RGBA8 texels (row-major, R in the low byte).
+// The encoders are used offline by `bake`, the decoders at load time on
+// devices that can't sample the baked format.
+namespace igfx::blocks {
+    constexpr u32 blockBytes = 16;
+
+    void encodeBC3(u32 const texels[16], u8 block[blockBytes]);
+    void decodeBC3(u8 const block[blockBytes], u32 texels[16]);
+
+    // Mode 6 only (one subset, RGBA endpoints with 4 bit indices).
+    void encodeBC7(u32 const texels[16], u8 block[blockBytes]);
+    // Decodes mode 6 blocks, other modes decode to magenta.
+    void decodeBC7(u8 const block[blockBytes], u32 texels[16]);
+}
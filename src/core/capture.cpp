@@ -0,0 +1,144 @@
+#include "core/capture.h"
+#include "core/textures.h"
+#include "arena.h"
+
+#include <std/math.h>
+
+#include <stdio.h>
+
+namespace igfx::capture {
+    // Frames are appended to the arena and the pages written out in order
+    // once enough of them pile up, so capturing costs a memcpy per frame.
+    struct Capture {
+        static constexpr usize flushBytes = 1 << 20;
+
+        FILE* file;
+        Arena* arena;
+        u32 frameIndex;
+        // Textures and sprite table entries recorded so far, index 0 is
+        // the default sprite in both.
+        u32 textureCount;
+        u32 spriteInfoCount;
+    };
+
+    Capture capture;
+
+    void writePages(Arena::Page* page) {
+        if (page == nullptr) return;
+
+        writePages(page->previous);
+        fwrite(page->bytes, 1, page->count, capture.file);
+    }
+
+    void flush() {
+        writePages(capture.arena->page);
+        capture.arena->reset();
+    }
+
+    void append(void const* data, usize bytes) {
+        u8 const* src = (u8 const*)data;
+        while (bytes > 0) {
+            usize chunk = bytes < Arena::pageBytesCount ? bytes : Arena::pageBytesCount;
+            __builtin_memcpy(capture.arena->alloc<u8>(chunk), src, chunk);
+
+            src += chunk;
+            bytes -= chunk;
+        }
+    }
+
+    void begin(u8 const* path, u32 width, u32 height) {
+        capture.file = fopen(path, "wb");
+        if (capture.file == nullptr) {
+            std::err("failed to open capture file '{}'", path);
+            return;
+        }
+
+        capture.arena = new Arena();
+        capture.frameIndex = 0;
+        capture.textureCount = 1;
+        capture.spriteInfoCount = 1;
+
+        Header header {
+            .version = version,
+            .width = width,
+            .height = height,
+            .spriteCommandSize = sizeof(graphics::SpriteCommand),
+            .spriteInfoSize = sizeof(graphics::SpriteInfo),
+        };
+        __builtin_memcpy(header.magic, magic, sizeof(magic));
+        append(&header, sizeof(header));
+
+        std::debug("capturing frames to '{}'", path);
+    }
+
+    void end() {
+        if (!active()) return;
+
+        flush();
+        fclose(capture.file);
+        delete capture.arena;
+
+        std::debug("captured {} frames", capture.frameIndex);
+        capture = {};
+    }
+
+    bool active() {
+        return capture.file != nullptr;
+    }
+
+    void texture(graphics::Texture const& texture) {
+        TextureRecord record {
+            .source = TextureSource::Pixels,
+            .width = texture.width,
+            .height = texture.height,
+        };
+
+        if (texture.external) {
+            record.source = TextureSource::Atlas;
+            append(&record, sizeof(record));
+        } else if (texture.path[0] != '\0') {
+            record.source = TextureSource::Path;
+            record.bytes = (u32)__builtin_strlen(texture.path) + 1;
+            append(&record, sizeof(record));
+            append(texture.path, record.bytes);
+        } else {
+            record.bytes = texture.width * texture.height * sizeof(u32);
+            append(&record, sizeof(record));
+            append(texture.data.ptr, record.bytes);
+        }
+    }
+
+    // Assets are registered before the frames drawing them are recorded,
+    // the render thread sees them through the frame handoff.
+    void frame(
+        f32 deltaTime,
+        f32 userTime,
+        std::Slice<graphics::SpriteCommand> commands
+    ) {
+        graphics::Textures const& textures = graphics::textures;
+        graphics::SpriteTable const& table = graphics::spriteTable;
+
+        u32 textureCount = std::max(textures.count, 1u);
+        FrameRecord record {
+            .index = capture.frameIndex++,
+            .textureCount = textureCount - capture.textureCount,
+            .spriteInfoCount = table.count - capture.spriteInfoCount,
+            .spriteCount = (u32)commands.len,
+            .deltaTime = deltaTime,
+            .userTime = userTime,
+        };
+
+        append(&record, sizeof(record));
+        for (u32 i = capture.textureCount; i < textureCount; i++) texture(textures.entries[i]);
+        append(
+            &table.entries[capture.spriteInfoCount],
+            record.spriteInfoCount * sizeof(graphics::SpriteInfo)
+        );
+        append(commands.ptr, commands.len * sizeof(graphics::SpriteCommand));
+
+        capture.textureCount = textureCount;
+        capture.spriteInfoCount = table.count;
+
+        if (capture.arena->size() >= Capture::flushBytes) flush();
+    }
+}
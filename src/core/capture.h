@@ -0,0 +1,60 @@
+#pragma once
+#include <std/slice.h>
+
+#include "core/sprites.h"
+
+// Binary capture of every submitted frame, a `Header` followed by one
+// `FrameRecord` per frame. Each is directly followed by the textures and
+// sprite table entries added since the previous frame, so a replay can
+// rebuild what the commands refer to, and then by its sprite commands.
+namespace igfx::capture {
+    // 2: SpriteCommand::rotation
+    // 3: SpriteCommand::blend
+    // 4: SpriteCommand::color
+    // 5: texture and sprite table records
+    constexpr u32 version = 5;
+
+    struct Header {
+        u8 magic[8];
+        u32 version;
+        u32 width;
+        u32 height;
+        u32 spriteCommandSize;
+        u32 spriteInfoSize;
+    };
+
+    // What a replay rebuilds a texture from.
+    enum class TextureSource : u32 {
+        Path,   // `loadTexture`, followed by the path (NUL terminated)
+        Pixels, // `createTexture`, followed by its RGBA8 pixels
+        Atlas,  // the glyph atlas, glyph pixels are not captured
+    };
+
+    struct TextureRecord {
+        TextureSource source;
+        u32 width;
+        u32 height;
+        u32 bytes; // following the record
+    };
+
+    struct FrameRecord {
+        u32 index;
+        u32 textureCount; // `TextureRecord`s
+        u32 spriteInfoCount; // `SpriteInfo`s appended to the table
+        u32 spriteCount;
+        f32 deltaTime;
+        f32 userTime; // seconds spent outside the engine (update + draw)
+    };
+
+    constexpr u8 magic[8] = {'i', 'g', 'f', 'x', 'c', 'a', 'p', '\0'};
+
+    void begin(u8 const* path, u32 width, u32 height);
+    void end();
+    bool active();
+
+    void frame(
+        f32 deltaTime,
+        f32 userTime,
+        std::Slice<graphics::SpriteCommand> commands
+    );
+}
@@ -1,6 +1,11 @@
 #include "core/graphics.h"
+#include "core/spritebatch.h"
+#include "core/textures.h"
+#include "core/text.h"
 #include "core/window.h"
 #include "igfx/window.h"
+#include "core/timer.h"
+#include "core/startup.h"
 
 #include <std/alloc.h>
 #include <std/slice.h>
@@ -16,6 +21,14 @@ namespace igfx::graphics {
         VK_KHR_SWAPCHAIN_EXTENSION_NAME
     );
 
+#ifdef DEBUG
+    auto enabledLayerNames = std::arr<u8 const*>(
+        "VK_LAYER_KHRONOS_validation"
+    );
+#else
+    std::Array<u8 const*, 0> enabledLayerNames;
+#endif
+
 #ifdef DEBUG
     VkBool32 vkDebugCallback(
         VkDebugReportFlagsEXT flags, 
@@ -61,7 +74,7 @@ namespace igfx::graphics {
         u32 vkExtensionCount;
         vkEnumerateInstanceExtensionProperties(nullptr, &vkExtensionCount, nullptr);
     
-        auto vkExtensions = arena.alloc<VkExtensionProperties>(vkExtensionCount;
+        auto vkExtensions = arena.alloc<VkExtensionProperties>(vkExtensionCount);
         vkEnumerateInstanceExtensionProperties(
             nullptr, 
             &vkExtensionCount, 
@@ -87,7 +100,7 @@ namespace igfx::graphics {
 		    .applicationVersion = VK_MAKE_VERSION(1, 0, 0),
 		    .pEngineName = "igfx",
 		    .engineVersion = VK_MAKE_VERSION(1, 0, 0),
-		    .apiVersion = VK_API_VERSION_1_0,
+		    .apiVersion = VK_API_VERSION_1_3,
         };
     
         VkInstanceCreateInfo instanceCreateInfo {
@@ -112,7 +125,8 @@ namespace igfx::graphics {
             &instance
         );
         if (result != VK_SUCCESS) {
-            std::fatal("failed to create a VkInstance (errno: {})", (i32)result);
+            std::warn("failed to create a VkInstance (errno: {})", (i32)result);
+            return nullptr;
         }
 
         std::debug("VkInstance created");
@@ -145,14 +159,30 @@ namespace igfx::graphics {
         VkPhysicalDeviceProperties properties;
         vkGetPhysicalDeviceProperties(device, &properties);
 
-        VkPhysicalDeviceFeatures features;
-        vkGetPhysicalDeviceFeatures(device, &features);
+        if (properties.apiVersion < VK_API_VERSION_1_3) return 0;
+
+        VkPhysicalDeviceVulkan13Features vulkan13Features {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES,
+        };
+
+        VkPhysicalDeviceFeatures2 features {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+            .pNext = &vulkan13Features,
+        };
+        vkGetPhysicalDeviceFeatures2(device, &features);
+
+        if (!vulkan13Features.dynamicRendering || !vulkan13Features.synchronization2) {
+            return 0;
+        }
 
         u32 score = 1 + properties.limits.maxImageDimension2D;
         if (properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU) {
             score += 1000;
         }
 
+        // More VRAM means fewer textures evicted, in 16 MiB units.
+        score += (u32)(deviceLocalHeapSize(device, nullptr) >> 24);
+
         return score;
     }
 
@@ -162,7 +192,7 @@ namespace igfx::graphics {
     ) {
         u32 deviceCount;
         vkEnumeratePhysicalDevices(instance, &deviceCount, nullptr);
-        if (deviceCount == 0) std::fatal("failed to find a GPU with vulkan support");
+        if (deviceCount == 0) return nullptr;
 
         auto devices = arena.alloc<VkPhysicalDevice>(deviceCount);
         vkEnumeratePhysicalDevices(instance, &deviceCount, devices.ptr);
@@ -178,8 +208,7 @@ namespace igfx::graphics {
             }
         }
 
-        if (selectedDevice == nullptr) std::fatal("failed to find a suitable GPU");
-        return selectedDevice;
+        return selectedDevice; // nullptr when none is suitable
     }
 
     inline VkSurfaceFormatKHR findVkSurfaceFormat(
@@ -219,6 +248,7 @@ namespace igfx::graphics {
     inline VkPresentModeKHR findVkPresentMode(
         VkPhysicalDevice physicalDevice,
         VkSurfaceKHR surface,
+        PresentMode requested,
         std::Allocator arena
     ) {
         u32 presentModeCount;
@@ -238,14 +268,76 @@ namespace igfx::graphics {
             presentModes.ptr
         );
 
+        VkPresentModeKHR requestedMode = VK_PRESENT_MODE_FIFO_KHR;
+        switch (requested) {
+        case PresentMode::Fifo: requestedMode = VK_PRESENT_MODE_FIFO_KHR; break;
+        case PresentMode::FifoRelaxed: requestedMode = VK_PRESENT_MODE_FIFO_RELAXED_KHR; break;
+        case PresentMode::Mailbox: requestedMode = VK_PRESENT_MODE_MAILBOX_KHR; break;
+        case PresentMode::Immediate: requestedMode = VK_PRESENT_MODE_IMMEDIATE_KHR; break;
+        }
+
         for (VkPresentModeKHR mode : presentModes) {
-            if (mode == VK_PRESENT_MODE_MAILBOX_KHR) return mode;
+            if (mode == requestedMode) return mode;
         }
 
+        std::warn("present mode {} unavailable, using FIFO", (i32)requestedMode);
         return VK_PRESENT_MODE_FIFO_KHR;
     }
 
+    inline bool supportsExtension(
+        VkPhysicalDevice physicalDevice,
+        u8 const* name,
+        std::Allocator arena
+    ) {
+        u32 extensionCount;
+        vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+
+        auto extensions = arena.alloc<VkExtensionProperties>(extensionCount);
+        vkEnumerateDeviceExtensionProperties(
+            physicalDevice,
+            nullptr,
+            &extensionCount,
+            extensions.ptr
+        );
+
+        for (VkExtensionProperties extension : extensions) {
+            if (std::eqlZ(extension.extensionName, name)) return true;
+        }
+
+        return false;
+    }
+
+    inline bool supportsPresentWait(VkPhysicalDevice physicalDevice, std::Allocator arena) {
+        if (
+            !supportsExtension(physicalDevice, VK_KHR_PRESENT_ID_EXTENSION_NAME, arena)
+            || !supportsExtension(physicalDevice, VK_KHR_PRESENT_WAIT_EXTENSION_NAME, arena)
+        ) return false;
+
+        VkPhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR,
+        };
+
+        VkPhysicalDevicePresentIdFeaturesKHR presentIdFeatures {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR,
+            .pNext = &presentWaitFeatures,
+        };
+
+        VkPhysicalDeviceFeatures2 features {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+            .pNext = &presentIdFeatures,
+        };
+        vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
+
+        return presentIdFeatures.presentId && presentWaitFeatures.presentWait;
+    }
+
     inline VkExtent2D findVkExtent2D(VkSurfaceCapabilitiesKHR surfaceCapabilities) {
+        // Most surfaces dictate the extent, 0xFFFFFFFF lets the swapchain
+        // choose (e.g. Wayland).
+        if (surfaceCapabilities.currentExtent.width != 0xFFFFFFFF) {
+            return surfaceCapabilities.currentExtent;
+        }
+
         u32 minWidth = surfaceCapabilities.minImageExtent.width;
         u32 maxWidth = surfaceCapabilities.maxImageExtent.width;
 
@@ -253,8 +345,8 @@ namespace igfx::graphics {
         u32 maxHeight = surfaceCapabilities.maxImageExtent.height;
 
         return {
-            std::clamp(window::width(), minWidth, maxWidth),
-            std::clamp(window::height(), minHeight, maxHeight),
+            std::clamp(window::window.framebufferWidth, minWidth, maxWidth),
+            std::clamp(window::window.framebufferHeight, minHeight, maxHeight),
         };
     }
 
@@ -310,21 +402,523 @@ namespace igfx::graphics {
         }
     }
 
-    void init() {
+    u32 findMemoryType(u32 memoryTypeBits, VkMemoryPropertyFlags properties) {
+        VkPhysicalDeviceMemoryProperties memoryProperties;
+        vkGetPhysicalDeviceMemoryProperties(graphics.physicalDevice, &memoryProperties);
+
+        for (u32 i = 0; i < memoryProperties.memoryTypeCount; i++) {
+            if (
+                (memoryTypeBits & (1 << i)) != 0
+                && (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties
+            ) return i;
+        }
+
+        std::fatal("failed to find a suitable memory type");
+    }
+
+    Buffer createBuffer(
+        VkDeviceSize size,
+        VkBufferUsageFlags usage,
+        VkMemoryPropertyFlags properties
+    ) {
+        Buffer buffer {.size = size};
+
+        VkBufferCreateInfo bufferCreateInfo {
+            .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+            .size = size,
+            .usage = usage,
+            .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+        };
+
+        if (vkCreateBuffer(
+            graphics.device,
+            &bufferCreateInfo,
+            nullptr,
+            &buffer.buffer
+        ) != VK_SUCCESS) std::fatal("failed to create buffer");
+
+        VkMemoryRequirements requirements;
+        vkGetBufferMemoryRequirements(graphics.device, buffer.buffer, &requirements);
+
+        VkMemoryAllocateInfo allocateInfo {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+            .allocationSize = requirements.size,
+            .memoryTypeIndex = findMemoryType(requirements.memoryTypeBits, properties),
+        };
+
+        if (vkAllocateMemory(
+            graphics.device,
+            &allocateInfo,
+            nullptr,
+            &buffer.memory
+        ) != VK_SUCCESS) std::fatal("failed to allocate buffer memory");
+
+        vkBindBufferMemory(graphics.device, buffer.buffer, buffer.memory, 0);
+
+        if (properties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+            vkMapMemory(graphics.device, buffer.memory, 0, size, 0, &buffer.mapped);
+        }
+
+        return buffer;
+    }
+
+    void destroyBuffer(Buffer const& buffer) {
+        if (buffer.mapped != nullptr) vkUnmapMemory(graphics.device, buffer.memory);
+        vkDestroyBuffer(graphics.device, buffer.buffer, nullptr);
+        vkFreeMemory(graphics.device, buffer.memory, nullptr);
+    }
+
+    VkCommandBuffer beginImmediate() {
+        VkCommandBufferAllocateInfo allocateInfo {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+            .commandPool = graphics.commandPool,
+            .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+            .commandBufferCount = 1,
+        };
+
+        VkCommandBuffer commandBuffer;
+        if (vkAllocateCommandBuffers(
+            graphics.device,
+            &allocateInfo,
+            &commandBuffer
+        ) != VK_SUCCESS) std::fatal("failed to allocate command buffer");
+
+        VkCommandBufferBeginInfo beginInfo {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+            .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+        };
+        vkBeginCommandBuffer(commandBuffer, &beginInfo);
+
+        return commandBuffer;
+    }
+
+    void endImmediate(VkCommandBuffer commandBuffer) {
+        vkEndCommandBuffer(commandBuffer);
+
+        VkCommandBufferSubmitInfo commandBufferInfo {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO,
+            .commandBuffer = commandBuffer,
+        };
+
+        VkSubmitInfo2 submitInfo {
+            .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2,
+            .commandBufferInfoCount = 1,
+            .pCommandBufferInfos = &commandBufferInfo,
+        };
+
+        if (vkQueueSubmit2(
+            graphics.graphicsQueue,
+            1,
+            &submitInfo,
+            nullptr
+        ) != VK_SUCCESS) std::fatal("failed to submit upload");
+
+        vkQueueWaitIdle(graphics.graphicsQueue);
+        vkFreeCommandBuffers(graphics.device, graphics.commandPool, 1, &commandBuffer);
+    }
+
+    void createSwapchain() {
+        VkSurfaceCapabilitiesKHR surfaceCapabilities;
+        vkGetPhysicalDeviceSurfaceCapabilitiesKHR(
+            graphics.physicalDevice,
+            graphics.surface,
+            &surfaceCapabilities
+        );
+
+        VkExtent2D swapchainExtent = findVkExtent2D(surfaceCapabilities);
+        VkSurfaceFormatKHR surfaceFormat = graphics.swapchainSurfaceFormat;
+
+        u32 imageCount = graphics.requestedImageCount;
+        if (imageCount == 0) imageCount = surfaceCapabilities.minImageCount + 1;
+        if (imageCount < surfaceCapabilities.minImageCount) {
+            imageCount = surfaceCapabilities.minImageCount;
+        }
+
+        // A maximum of 0 means unlimited.
+        if (
+            surfaceCapabilities.maxImageCount != 0 
+            && imageCount > surfaceCapabilities.maxImageCount
+        ) imageCount = surfaceCapabilities.maxImageCount;
+
+        VkSwapchainCreateInfoKHR swapchainCreateInfo {
+            .sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR,
+            .surface = graphics.surface,
+            .minImageCount = imageCount,
+            .imageFormat = surfaceFormat.format,
+            .imageColorSpace = surfaceFormat.colorSpace,
+            .imageExtent = swapchainExtent,
+            .imageArrayLayers = 1,
+            .imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT
+                | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+            .preTransform = surfaceCapabilities.currentTransform,
+            .compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR,
+            .presentMode = graphics.swapchainPresentMode,
+            .clipped = VK_TRUE,
+            .oldSwapchain = nullptr,
+        };
+
+        auto queueFamilyIndices = std::arr<u32>( 
+            graphics.graphicsQueueFamilyIndex,
+            graphics.presentQueueFamilyIndex
+        );
+
+        if (graphics.graphicsQueueFamilyIndex != graphics.presentQueueFamilyIndex) {
+            swapchainCreateInfo.imageSharingMode = VK_SHARING_MODE_CONCURRENT;
+            swapchainCreateInfo.queueFamilyIndexCount = queueFamilyIndices.len();
+            swapchainCreateInfo.pQueueFamilyIndices = queueFamilyIndices.data;
+        } else {
+            swapchainCreateInfo.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        }
+
+        VkSwapchainKHR swapchain;
+        VkResult swapchainResult = vkCreateSwapchainKHR(
+            graphics.device, 
+            &swapchainCreateInfo, 
+            nullptr, 
+            &swapchain
+        );
+
+        if (swapchainResult != VK_SUCCESS) {
+            std::fatal("failed to create swapchain (errno: {})", (i32)swapchainResult);
+        }
+
+        u32 swapchainImageCount;
+        vkGetSwapchainImagesKHR(graphics.device, swapchain, &swapchainImageCount, nullptr);
+
+        auto swapchainImages = std::alloc<VkImage>(swapchainImageCount);
+        vkGetSwapchainImagesKHR(
+            graphics.device, 
+            swapchain, 
+            &swapchainImageCount, 
+            swapchainImages.ptr
+        );
+
+        auto swapchainImageViews = std::alloc<VkImageView>(swapchainImageCount);
+        auto renderFinished = std::alloc<VkSemaphore>(swapchainImageCount);
+        for (u32 i = 0; i < swapchainImageCount; i++) {
+            VkImageViewCreateInfo imageViewCreateInfo {
+                .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+                .image = swapchainImages[i],
+                .viewType = VK_IMAGE_VIEW_TYPE_2D,
+                .format = surfaceFormat.format,
+                .components = {
+                    .r = VK_COMPONENT_SWIZZLE_IDENTITY,
+                    .g = VK_COMPONENT_SWIZZLE_IDENTITY,
+                    .b = VK_COMPONENT_SWIZZLE_IDENTITY,
+                    .a = VK_COMPONENT_SWIZZLE_IDENTITY,
+                },
+                .subresourceRange = {
+                    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                    .baseMipLevel = 0,
+                    .levelCount = 1,
+                    .baseArrayLayer = 0,
+                    .layerCount = 1,
+                },
+            };
+
+            if (vkCreateImageView(
+                graphics.device, 
+                &imageViewCreateInfo, 
+                nullptr, 
+                &swapchainImageViews[i]
+            ) != VK_SUCCESS) std::fatal("failed to create image view");
+
+            VkSemaphoreCreateInfo semaphoreCreateInfo {
+                .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+            };
+
+            if (vkCreateSemaphore(
+                graphics.device,
+                &semaphoreCreateInfo,
+                nullptr,
+                &renderFinished[i]
+            ) != VK_SUCCESS) std::fatal("failed to create semaphore");
+        }
+
+        graphics.swapchainImageFormat = surfaceFormat.format;
+        graphics.swapchainExtent = swapchainExtent;
+        graphics.swapchain = swapchain;
+        graphics.swapchainImages = swapchainImages;
+        graphics.swapchainImageViews = swapchainImageViews;
+        graphics.renderFinished = renderFinished;
+    }
+
+    void destroySwapchain() {
+        for (VkSemaphore semaphore : graphics.renderFinished) {
+            vkDestroySemaphore(graphics.device, semaphore, nullptr);
+        }
+        std::free(graphics.renderFinished);
+
+        for (VkImageView view : graphics.swapchainImageViews) {
+            vkDestroyImageView(graphics.device, view, nullptr);
+        }
+        std::free(graphics.swapchainImageViews);
+        std::free(graphics.swapchainImages);
+
+        vkDestroySwapchainKHR(graphics.device, graphics.swapchain, nullptr);
+    }
+
+    inline VkExtent2D scaledExtent(VkExtent2D extent, f32 scale) {
+        return {
+            std::max((u32)((f32)extent.width * scale + 0.5f), 1u),
+            std::max((u32)((f32)extent.height * scale + 0.5f), 1u),
+        };
+    }
+
+    // Linear blit of the scene's rendered part over the whole swapchain
+    // image.
+    void upscalePass(PassContext* context, void*) {
+        DynamicResolution const& resolution = graphics.resolution;
+
+        VkImageSubresourceLayers subresource {
+            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .mipLevel = 0,
+            .baseArrayLayer = 0,
+            .layerCount = 1,
+        };
+
+        VkImageBlit blit {
+            .srcSubresource = subresource,
+            .srcOffsets = {
+                {0, 0, 0},
+                {(i32)resolution.renderExtent.width, (i32)resolution.renderExtent.height, 1},
+            },
+            .dstSubresource = subresource,
+            .dstOffsets = {
+                {0, 0, 0},
+                {(i32)graphics.swapchainExtent.width, (i32)graphics.swapchainExtent.height, 1},
+            },
+        };
+
+        vkCmdBlitImage(
+            context->commandBuffer,
+            context->graph->image(resolution.sceneTarget),
+            VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            context->graph->image(graphics.swapchainTarget),
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            1,
+            &blit,
+            VK_FILTER_LINEAR
+        );
+    }
+
+    // The scene's draws between a pair of timestamps, the GPU time the
+    // render scale adapts to. The first waits for the uploads and copies
+    // recorded before it, so only the scene is measured.
+    void timedScenePass(PassContext* context, void* userData) {
+        DynamicResolution& resolution = graphics.resolution;
+        u32 firstQuery = graphics.frameIndex * 2;
+
+        vkCmdWriteTimestamp2(
+            context->commandBuffer,
+            VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+            resolution.timestamps,
+            firstQuery
+        );
+
+        scenePass(context, userData);
+
+        vkCmdWriteTimestamp2(
+            context->commandBuffer,
+            VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+            resolution.timestamps,
+            firstQuery + 1
+        );
+        resolution.timed[graphics.frameIndex] = true;
+    }
+
+    // Declares the passes of a frame, rebuilt whenever the swapchain is.
+    void buildGraph() {
+        RenderGraph& graph = graphics.graph;
+        graph.reset();
+
+        graphics.swapchainTarget = graph.importImage(
+            {
+                .format = graphics.swapchainImageFormat,
+                .extent = graphics.swapchainExtent,
+                .usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT
+                    | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+            },
+            Access::None,
+            Access::Present,
+            true
+        );
+
+        DynamicResolution& resolution = graphics.resolution;
+        if (!resolution.enabled) {
+            graph.addPass("sprites", spritePass, nullptr).color(
+                graphics.swapchainTarget,
+                VK_ATTACHMENT_LOAD_OP_CLEAR,
+                {.float32 = {0.0f, 0.0f, 0.0f, 1.0f}}
+            );
+
+            graph.compile();
+            return;
+        }
+
+        // Allocated at the maximum scale, each frame renders a part of it.
+        resolution.sceneTarget = graph.createImage({
+            .format = graphics.swapchainImageFormat,
+            .extent = scaledExtent(graphics.swapchainExtent, resolution.maxScale),
+            .usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT
+                | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+        });
+
+        Pass& scene = graph.addPass("scene", timedScenePass, nullptr);
+        scene.color(
+            resolution.sceneTarget,
+            VK_ATTACHMENT_LOAD_OP_CLEAR,
+            {.float32 = {0.0f, 0.0f, 0.0f, 1.0f}}
+        );
+        resolution.scenePass = &scene;
+
+        Pass& upscale = graph.addPass("upscale", upscalePass, nullptr);
+        upscale.read(resolution.sceneTarget, Access::TransferSrc);
+        upscale.write(graphics.swapchainTarget, Access::TransferDst);
+
+        graph.addPass("text", textPass, nullptr).color(
+            graphics.swapchainTarget,
+            VK_ATTACHMENT_LOAD_OP_LOAD
+        );
+
+        graph.compile();
+    }
+
+    void recreateSwapchain() {
+        vkDeviceWaitIdle(graphics.device);
+        window::window.resized = false;
+
+        graphics.graph.deinit();
+        destroySwapchain();
+
+        createSwapchain();
+        buildGraph();
+    }
+
+    // Needs linear blits of the swapchain format and timestamps on the
+    // graphics queue, disabled with a warning otherwise.
+    void initDynamicResolution(Config const& config, VkFormat format) {
+        DynamicResolution& resolution = graphics.resolution;
+        resolution = {};
+        if (!config.dynamicResolution) return;
+
+        VkFormatProperties formatProperties;
+        vkGetPhysicalDeviceFormatProperties(graphics.physicalDevice, format, &formatProperties);
+
+        VkFormatFeatureFlags blit = VK_FORMAT_FEATURE_BLIT_SRC_BIT
+            | VK_FORMAT_FEATURE_BLIT_DST_BIT
+            | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+        if ((formatProperties.optimalTilingFeatures & blit) != blit) {
+            std::warn("dynamic resolution needs linear blits of the swapchain format, disabled");
+            return;
+        }
+
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(graphics.physicalDevice, &properties);
+        if (!properties.limits.timestampComputeAndGraphics) {
+            std::warn("dynamic resolution needs GPU timestamps, disabled");
+            return;
+        }
+
+        VkQueryPoolCreateInfo queryPoolInfo {
+            .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+            .queryType = VK_QUERY_TYPE_TIMESTAMP,
+            .queryCount = 2 * framesInFlight,
+        };
+
+        if (vkCreateQueryPool(
+            graphics.device,
+            &queryPoolInfo,
+            nullptr,
+            &resolution.timestamps
+        ) != VK_SUCCESS) std::fatal("failed to create timestamp query pool");
+
+        resolution.enabled = true;
+        resolution.budget = config.frameBudget;
+        resolution.maxScale = std::clamp(config.maxRenderScale, 0.1f, 2.0f);
+        resolution.minScale = std::clamp(config.minRenderScale, 0.1f, resolution.maxScale);
+        resolution.scale = std::clamp(1.0f, resolution.minScale, resolution.maxScale);
+        resolution.timestampPeriod = properties.limits.timestampPeriod;
+
+        std::debug(
+            "dynamic resolution: {} ms budget, scale {} to {}",
+            resolution.budget * 1000.0f,
+            resolution.minScale,
+            resolution.maxScale
+        );
+    }
+
+    // Reads the GPU time of the frame that last used `frameIndex` (its
+    // fence was waited on) and picks this frame's render extent.
+    void updateRenderScale(u32 frameIndex) {
+        DynamicResolution& resolution = graphics.resolution;
+
+        u64 ticks[2];
+        if (
+            resolution.timed[frameIndex]
+            && vkGetQueryPoolResults(
+                graphics.device,
+                resolution.timestamps,
+                frameIndex * 2,
+                2,
+                sizeof(ticks),
+                ticks,
+                sizeof(u64),
+                VK_QUERY_RESULT_64_BIT
+            ) == VK_SUCCESS
+        ) {
+            f32 gpuTime = (f32)((f64)(ticks[1] - ticks[0]) * resolution.timestampPeriod * 1e-9);
+            resolution.gpuTime = resolution.gpuTime == 0.0f
+                ? gpuTime
+                : resolution.gpuTime + (gpuTime - resolution.gpuTime) * 0.1f;
+
+            if (resolution.gpuTime > resolution.budget * DynamicResolution::high) {
+                resolution.over++;
+                resolution.under = 0;
+            } else if (resolution.gpuTime < resolution.budget * DynamicResolution::low) {
+                resolution.under++;
+                resolution.over = 0;
+            } else {
+                resolution.over = 0;
+                resolution.under = 0;
+            }
+
+            if (
+                resolution.over >= DynamicResolution::overFrames
+                || resolution.under >= DynamicResolution::underFrames
+            ) {
+                // GPU time follows the pixel count, the square of the scale.
+                // Aim for the middle of the band.
+                f32 target = resolution.budget * (DynamicResolution::low + DynamicResolution::high) * 0.5f;
+                f32 scale = resolution.scale * __builtin_sqrtf(target / resolution.gpuTime);
+                scale = std::clamp(
+                    scale,
+                    resolution.scale - DynamicResolution::maxStep,
+                    resolution.scale + DynamicResolution::maxStep
+                );
+                resolution.scale = std::clamp(scale, resolution.minScale, resolution.maxScale);
+
+                // The smoothed time is of the old scale, start over.
+                resolution.gpuTime = 0.0f;
+                resolution.over = 0;
+                resolution.under = 0;
+            }
+        }
+        resolution.timed[frameIndex] = false;
+
+        resolution.renderExtent = scaledExtent(graphics.swapchainExtent, resolution.scale);
+        resolution.scenePass->renderArea = resolution.renderExtent;
+    }
+
+    bool initInstance() {
         std::Arena arena;
         defer { arena.deinit(); };
 
-#ifdef DEBUG
-        auto ppEnabledLayerNames = std::arr<u8 const*>(
-            "VK_LAYER_KHRONOS_validation"
-        );
-#else
-        std::Array<u8 const*, 0> ppEnabledLayerNames;
-#endif
         VkInstance instance = createVkInstance(
-            ppEnabledLayerNames.buf(), 
+            enabledLayerNames.buf(), 
             arena.allocator()
         );
+        if (instance == nullptr) return false;
     
 #ifdef DEBUG
         VkDebugReportCallbackCreateInfoEXT debugCreateInfo {
@@ -339,7 +933,7 @@ namespace igfx::graphics {
             "vkCreateDebugReportCallbackEXT"
         );
     
-        VkDebugReportCallbackEXT debugCallback;
+        VkDebugReportCallbackEXT debugCallback = nullptr;
     	if (vkCreateDebugReportCallback(
             instance, 
             &debugCreateInfo, 
@@ -354,6 +948,41 @@ namespace igfx::graphics {
             instance, 
             arena.allocator()
         );
+
+        if (physicalDevice == nullptr) {
+#ifdef DEBUG
+            if (debugCallback != nullptr) {
+                PFN_vkDestroyDebugReportCallbackEXT vkDestroyDebugCallback = 
+                    (PFN_vkDestroyDebugReportCallbackEXT)vkGetInstanceProcAddr(
+                    instance,
+                    "vkDestroyDebugReportCallbackEXT"
+                );
+                vkDestroyDebugCallback(instance, debugCallback, nullptr);
+            }
+#endif
+            vkDestroyInstance(instance, nullptr);
+            return false;
+        }
+
+        graphics.instance = instance;
+        graphics.physicalDevice = physicalDevice;
+#ifdef DEBUG
+        graphics.debugCallback = debugCallback;
+#endif
+        return true;
+    }
+
+    void init(Config const& config) {
+        std::Arena arena;
+        defer { arena.deinit(); };
+
+        VkInstance instance = graphics.instance;
+        VkPhysicalDevice physicalDevice = graphics.physicalDevice;
+#ifdef DEBUG
+        VkDebugReportCallbackEXT debugCallback = graphics.debugCallback;
+#endif
+
+        u32 devicePhase = startup::phase("device");
         VkSurfaceKHR surface = window::createSurface(instance);
 
         u32 graphicsQueueFamilyIndex, presentQueueFamilyIndex;
@@ -381,15 +1010,85 @@ namespace igfx::graphics {
             }
         );
 
-        VkPhysicalDeviceFeatures deviceFeatures {};
+        u32 queueCreateInfoCount = graphicsQueueFamilyIndex == presentQueueFamilyIndex ? 1 : 2;
+
+        VkPresentModeKHR presentMode = findVkPresentMode(
+            physicalDevice, 
+            surface, 
+            config.presentMode,
+            arena.allocator()
+        );
+
+        bool presentWait = false;
+        if (config.lowLatency) {
+            if (
+                presentMode != VK_PRESENT_MODE_FIFO_KHR 
+                && presentMode != VK_PRESENT_MODE_FIFO_RELAXED_KHR
+            ) {
+                std::warn("low latency pacing needs a FIFO present mode, disabled");
+            } else if (!supportsPresentWait(physicalDevice, arena.allocator())) {
+                std::warn("VK_KHR_present_wait unsupported, low latency pacing disabled");
+            } else {
+                presentWait = true;
+            }
+        }
+
+        auto enabledExtensions = arena.allocator().alloc<u8 const*>(
+            requiredDeviceExtensions.len() + 3
+        );
+        u32 enabledExtensionCount = 0;
+        for (u8 const* extension : requiredDeviceExtensions) {
+            enabledExtensions[enabledExtensionCount++] = extension;
+        }
+
+        bool memoryBudget = supportsExtension(
+            physicalDevice,
+            VK_EXT_MEMORY_BUDGET_EXTENSION_NAME,
+            arena.allocator()
+        );
+        if (memoryBudget) {
+            enabledExtensions[enabledExtensionCount++] = VK_EXT_MEMORY_BUDGET_EXTENSION_NAME;
+        }
+
+        VkPhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR,
+            .presentWait = VK_TRUE,
+        };
+
+        VkPhysicalDevicePresentIdFeaturesKHR presentIdFeatures {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR,
+            .pNext = &presentWaitFeatures,
+            .presentId = VK_TRUE,
+        };
+
+        // The render graph relies on dynamic rendering and synchronization2.
+        VkPhysicalDeviceVulkan13Features vulkan13Features {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES,
+            .synchronization2 = VK_TRUE,
+            .dynamicRendering = VK_TRUE,
+        };
+
+        if (presentWait) {
+            enabledExtensions[enabledExtensionCount++] = VK_KHR_PRESENT_ID_EXTENSION_NAME;
+            enabledExtensions[enabledExtensionCount++] = VK_KHR_PRESENT_WAIT_EXTENSION_NAME;
+            vulkan13Features.pNext = &presentIdFeatures;
+        }
+
+        VkPhysicalDeviceFeatures supportedFeatures;
+        vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+
+        VkPhysicalDeviceFeatures deviceFeatures {
+            .textureCompressionBC = supportedFeatures.textureCompressionBC,
+        };
         VkDeviceCreateInfo deviceCreateInfo {
             .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
-            .queueCreateInfoCount = queueCreateInfos.len(),
+            .pNext = &vulkan13Features,
+            .queueCreateInfoCount = queueCreateInfoCount,
             .pQueueCreateInfos = queueCreateInfos.data,
-            .enabledLayerCount = ppEnabledLayerNames.len(),
-            .ppEnabledLayerNames = ppEnabledLayerNames.data,
-            .enabledExtensionCount = requiredDeviceExtensions.len(),
-            .ppEnabledExtensionNames = requiredDeviceExtensions.data,
+            .enabledLayerCount = enabledLayerNames.len(),
+            .ppEnabledLayerNames = enabledLayerNames.data,
+            .enabledExtensionCount = enabledExtensionCount,
+            .ppEnabledExtensionNames = enabledExtensions.ptr,
             .pEnabledFeatures = &deviceFeatures,
         };
 
@@ -412,122 +1111,317 @@ namespace igfx::graphics {
             surface,
             arena.allocator()
         );
-        VkPresentModeKHR presentMode = findVkPresentMode(
-            physicalDevice, 
-            surface, 
-            arena.allocator()
-        );
 
-        VkSurfaceCapabilitiesKHR surfaceCapabilities;
-        vkGetPhysicalDeviceSurfaceCapabilitiesKHR(
-            physicalDevice,
-            surface,
-            &surfaceCapabilities
-        );
+        VkCommandPoolCreateInfo commandPoolCreateInfo {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+            .flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+            .queueFamilyIndex = graphicsQueueFamilyIndex,
+        };
 
-        VkExtent2D swapchainExtent = findVkExtent2D(surfaceCapabilities);
+        VkCommandPool commandPool;
+        if (vkCreateCommandPool(
+            device,
+            &commandPoolCreateInfo,
+            nullptr,
+            &commandPool
+        ) != VK_SUCCESS) std::fatal("failed to create command pool");
 
-        VkSwapchainCreateInfoKHR swapchainCreateInfo {
-            .sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR,
+        graphics = {
+            .instance = instance,
+            .physicalDevice = physicalDevice,
+            .device = device,
+            .presentQueue = presentQueue,
+            .graphicsQueue = graphicsQueue,
+            .graphicsQueueFamilyIndex = graphicsQueueFamilyIndex,
+            .presentQueueFamilyIndex = presentQueueFamilyIndex,
             .surface = surface,
-            .minImageCount = surfaceCapabilities.minImageCount + 1,
-            .imageFormat = surfaceFormat.format,
-            .imageColorSpace = surfaceFormat.colorSpace,
-            .imageExtent = swapchainExtent,
-            .imageArrayLayers = 1,
-            .imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
-            .preTransform = surfaceCapabilities.currentTransform,
-            .compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR,
-            .presentMode = presentMode,
-            .clipped = VK_TRUE,
-            .oldSwapchain = nullptr,
+
+            .swapchainSurfaceFormat = surfaceFormat,
+            .swapchainPresentMode = presentMode,
+            .requestedImageCount = config.swapchainImageCount,
+
+            .memoryBudget = memoryBudget,
+            .textureCompressionBC = supportedFeatures.textureCompressionBC == VK_TRUE,
+
+            .presentWait = presentWait,
+            .presentId = 0,
+            .vkWaitForPresent = presentWait 
+                ? (PFN_vkWaitForPresentKHR)vkGetDeviceProcAddr(device, "vkWaitForPresentKHR")
+                : nullptr,
+
+            .commandPool = commandPool,
+            .frameIndex = 0,
+#ifdef DEBUG
+            .debugCallback = debugCallback,
+#endif
         };
 
-        auto queueFamilyIndices = std::arr<u32>( 
-            graphicsQueueFamilyIndex,
-            presentQueueFamilyIndex
-        );
+        // Pipelines compile on job threads from here on, while the
+        // swapchain and the rest are created.
+        u32 spritePhase = startup::phase("sprite batch");
+        spriteBatch.init(surfaceFormat.format);
+        startup::end(spritePhase);
+
+        for (FrameResources& frame : graphics.frames) {
+            VkCommandBufferAllocateInfo allocateInfo {
+                .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+                .commandPool = commandPool,
+                .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+                .commandBufferCount = 1,
+            };
 
-        if (graphicsQueueFamilyIndex != presentQueueFamilyIndex) {
-            swapchainCreateInfo.imageSharingMode = VK_SHARING_MODE_CONCURRENT;
-            swapchainCreateInfo.queueFamilyIndexCount = queueFamilyIndices.len();
-            swapchainCreateInfo.pQueueFamilyIndices = queueFamilyIndices.data;
-        } else {
-            swapchainCreateInfo.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            if (vkAllocateCommandBuffers(
+                device,
+                &allocateInfo,
+                &frame.commandBuffer
+            ) != VK_SUCCESS) std::fatal("failed to allocate command buffer");
+
+            VkSemaphoreCreateInfo semaphoreCreateInfo {
+                .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+            };
+
+            VkFenceCreateInfo fenceCreateInfo {
+                .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+                .flags = VK_FENCE_CREATE_SIGNALED_BIT,
+            };
+
+            if (
+                vkCreateSemaphore(device, &semaphoreCreateInfo, nullptr, &frame.imageAvailable) 
+                    != VK_SUCCESS
+                || vkCreateFence(device, &fenceCreateInfo, nullptr, &frame.inFlight) 
+                    != VK_SUCCESS
+            ) std::fatal("failed to create frame synchronization objects");
         }
+        startup::end(devicePhase);
 
-        VkSwapchainKHR swapchain;
-        VkResult swapchainResult = vkCreateSwapchainKHR(
-            device, 
-            &swapchainCreateInfo, 
-            nullptr, 
-            &swapchain
+        u32 swapchainPhase = startup::phase("swapchain");
+        initDynamicResolution(config, surfaceFormat.format);
+        createSwapchain();
+        startup::end(swapchainPhase);
+
+        u32 residencyPhase = startup::phase("textures + text atlas");
+        initResidency(spriteBatch.textureSetLayout, spriteBatch.sampler, config.textureBudget);
+        initTextAtlas(spriteBatch.textureSetLayout, spriteBatch.sampler);
+        startup::end(residencyPhase);
+
+        buildGraph();
+    }
+
+    // Low latency pacing. After presenting, wait until the frame is on screen
+    // and then sleep until the next frame has to start (one refresh after it,
+    // minus the estimated cost of a frame and a safety margin), so input is
+    // sampled and `update` runs as late as possible.
+    struct Pacer {
+        static constexpr f64 margin = 1e-3;
+        static constexpr u64 timeout = 100'000'000; // ns
+        // Present intervals the refresh interval is the shortest of, a
+        // frame that missed its vblank shows up as a longer one.
+        static constexpr u32 intervalCount = 64;
+
+        f64 lastPresent;
+        f64 refreshInterval;
+        f64 frameStart;
+        f64 frameCost; // CPU and GPU, from `frameStart` to the fence
+        f64 intervals[intervalCount];
+        u32 intervalIndex;
+    };
+
+    Pacer pacer;
+
+    // `fence` signals when the GPU finished the frame just presented.
+    void pace(VkFence fence, u64 presentId) {
+        // The cost of the frame just presented, rises immediately and
+        // decays slowly so a single spike keeps the margin up for a while.
+        if (
+            pacer.frameStart > 0.0
+            && vkWaitForFences(graphics.device, 1, &fence, VK_TRUE, Pacer::timeout) == VK_SUCCESS
+        ) {
+            f64 cost = timer::now() - pacer.frameStart;
+            pacer.frameCost = cost > pacer.frameCost
+                ? cost
+                : pacer.frameCost * 0.95 + cost * 0.05;
+        }
+
+        VkResult result = graphics.vkWaitForPresent(
+            graphics.device,
+            graphics.swapchain,
+            presentId,
+            Pacer::timeout
         );
 
-        if (swapchainResult != VK_SUCCESS) {
-            std::fatal("failed to create swapchain (errno: {})", (i32)swapchainResult);
+        f64 now = timer::now();
+        if (result == VK_SUCCESS && pacer.lastPresent > 0.0) {
+            pacer.intervals[pacer.intervalIndex++ % Pacer::intervalCount] = now - pacer.lastPresent;
+
+            // Averaging would include missed vblanks, push the next start
+            // later and miss again, the estimate only ever rising.
+            u32 count = std::min(pacer.intervalIndex, Pacer::intervalCount);
+            pacer.refreshInterval = pacer.intervals[0];
+            for (u32 i = 1; i < count; i++) {
+                pacer.refreshInterval = std::min(pacer.refreshInterval, pacer.intervals[i]);
+            }
         }
+        pacer.lastPresent = result == VK_SUCCESS ? now : 0.0;
 
-        u32 swapchainImageCount;
-        vkGetSwapchainImagesKHR(device, swapchain, &swapchainImageCount, nullptr);
+        if (pacer.lastPresent > 0.0 && pacer.refreshInterval > 0.0) {
+            f64 start = pacer.lastPresent + pacer.refreshInterval
+                - pacer.frameCost - Pacer::margin;
+            timer::sleep(start - timer::now());
+        }
 
-        auto swapchainImages = arena.allocator().alloc<VkImage>(swapchainImageCount);
+        pacer.frameStart = timer::now();
+    }
 
-        vkGetSwapchainImagesKHR(
-            device, 
-            swapchain, 
-            &swapchainImageCount, 
-            swapchainImages.ptr
+    void render(std::Slice<SpriteCommand> sprites) {
+        // Minimized, there is nothing to present to.
+        if (window::window.framebufferWidth == 0 || window::window.framebufferHeight == 0) return;
+
+        FrameResources& frame = graphics.frames[graphics.frameIndex];
+        vkWaitForFences(graphics.device, 1, &frame.inFlight, VK_TRUE, UINT64_MAX);
+
+        u32 imageIndex;
+        VkResult acquireResult = vkAcquireNextImageKHR(
+            graphics.device,
+            graphics.swapchain,
+            UINT64_MAX,
+            frame.imageAvailable,
+            nullptr,
+            &imageIndex
         );
 
-        auto swapchainImageViews = std::alloc<VkImageView>(swapchainImageCount);
-        for (u32 i = 0; i < swapchainImageCount; i++) {
-            VkImageViewCreateInfo imageViewCreateInfo {
-                .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
-                .image = swapchainImages[i],
-                .viewType = VK_IMAGE_VIEW_TYPE_2D,
-                .format = surfaceFormat.format,
-                .components = {
-                    .r = VK_COMPONENT_SWIZZLE_IDENTITY,
-                    .g = VK_COMPONENT_SWIZZLE_IDENTITY,
-                    .b = VK_COMPONENT_SWIZZLE_IDENTITY,
-                    .a = VK_COMPONENT_SWIZZLE_IDENTITY,
-                },
-                .subresourceRange = {
-                    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-                    .baseMipLevel = 0,
-                    .levelCount = 1,
-                    .baseArrayLayer = 0,
-                    .layerCount = 1,
-                },
-            };
+        if (acquireResult == VK_ERROR_OUT_OF_DATE_KHR) {
+            recreateSwapchain();
+            return;
+        }
 
-            if (vkCreateImageView(
-                device, 
-                &imageViewCreateInfo, 
-                nullptr, 
-                &swapchainImageViews[i]
-            ) != VK_SUCCESS) std::fatal("failed to create image view");
+        if (acquireResult != VK_SUCCESS && acquireResult != VK_SUBOPTIMAL_KHR) {
+            std::fatal("failed to acquire swapchain image (errno: {})", (i32)acquireResult);
         }
 
-        graphics = {
-            .instance = instance,
-            .device = device,
-            .presentQueue = presentQueue,
-            .graphicsQueue = graphicsQueue,
-            .surface = surface,
+        DynamicResolution& resolution = graphics.resolution;
+        if (resolution.enabled) updateRenderScale(graphics.frameIndex);
 
-            .swapchainImageFormat = surfaceFormat.format,
-            .swapchainExtent = swapchainExtent,
-            .swapchain = swapchain,
-            .swapchainImageViews = swapchainImageViews,
-#ifdef DEBUG
-            .debugCallback = debugCallback,
-#endif
+        vkResetFences(graphics.device, 1, &frame.inFlight);
+        spriteBatch.upload(graphics.frameIndex, sprites);
+        vkResetCommandBuffer(frame.commandBuffer, 0);
+
+        VkCommandBufferBeginInfo beginInfo {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+            .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+        };
+        vkBeginCommandBuffer(frame.commandBuffer, &beginInfo);
+
+        // Outside the render pass instance the timestamps are written in.
+        if (resolution.enabled) {
+            vkCmdResetQueryPool(
+                frame.commandBuffer,
+                resolution.timestamps,
+                graphics.frameIndex * 2,
+                2
+            );
+        }
+
+        updateResidency(frame.commandBuffer, graphics.frameIndex);
+        uploadGlyphs(frame.commandBuffer, graphics.frameIndex);
+
+        graphics.graph.setImage(
+            graphics.swapchainTarget,
+            graphics.swapchainImages[imageIndex],
+            graphics.swapchainImageViews[imageIndex]
+        );
+        graphics.graph.execute(frame.commandBuffer);
+
+        vkEndCommandBuffer(frame.commandBuffer);
+
+        VkSemaphoreSubmitInfo waitInfo {
+            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+            .semaphore = frame.imageAvailable,
+            .stageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
         };
+
+        VkSemaphoreSubmitInfo signalInfo {
+            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+            .semaphore = graphics.renderFinished[imageIndex],
+            .stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+        };
+
+        VkCommandBufferSubmitInfo commandBufferInfo {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO,
+            .commandBuffer = frame.commandBuffer,
+        };
+
+        VkSubmitInfo2 submitInfo {
+            .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2,
+            .waitSemaphoreInfoCount = 1,
+            .pWaitSemaphoreInfos = &waitInfo,
+            .commandBufferInfoCount = 1,
+            .pCommandBufferInfos = &commandBufferInfo,
+            .signalSemaphoreInfoCount = 1,
+            .pSignalSemaphoreInfos = &signalInfo,
+        };
+
+        if (vkQueueSubmit2(
+            graphics.graphicsQueue,
+            1,
+            &submitInfo,
+            frame.inFlight
+        ) != VK_SUCCESS) std::fatal("failed to submit frame");
+
+        u64 presentId = ++graphics.presentId;
+        VkPresentIdKHR presentIdInfo {
+            .sType = VK_STRUCTURE_TYPE_PRESENT_ID_KHR,
+            .swapchainCount = 1,
+            .pPresentIds = &presentId,
+        };
+
+        VkPresentInfoKHR presentInfo {
+            .sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
+            .pNext = graphics.presentWait ? &presentIdInfo : nullptr,
+            .waitSemaphoreCount = 1,
+            .pWaitSemaphores = &graphics.renderFinished[imageIndex],
+            .swapchainCount = 1,
+            .pSwapchains = &graphics.swapchain,
+            .pImageIndices = &imageIndex,
+        };
+
+        VkResult presentResult = vkQueuePresentKHR(graphics.presentQueue, &presentInfo);
+        graphics.frameIndex = (graphics.frameIndex + 1) % framesInFlight;
+
+        if (
+            presentResult == VK_ERROR_OUT_OF_DATE_KHR
+            || presentResult == VK_SUBOPTIMAL_KHR
+            || window::window.resized
+        ) {
+            recreateSwapchain();
+            // The window may have moved to a display with another rate.
+            pacer.lastPresent = 0.0;
+            pacer.intervalIndex = 0;
+        } else if (presentResult != VK_SUCCESS) {
+            std::fatal("failed to present (errno: {})", (i32)presentResult);
+        } else if (graphics.presentWait) {
+            pace(frame.inFlight, presentId);
+        }
     }
 
     void deinit() {
+        vkDeviceWaitIdle(graphics.device);
+
+        graphics.graph.deinit();
+        destroySwapchain();
+        deinitResidency();
+        deinitTextAtlas();
+        spriteBatch.deinit();
+
+        if (graphics.resolution.enabled) {
+            vkDestroyQueryPool(graphics.device, graphics.resolution.timestamps, nullptr);
+        }
+
+        for (FrameResources& frame : graphics.frames) {
+            vkDestroySemaphore(graphics.device, frame.imageAvailable, nullptr);
+            vkDestroyFence(graphics.device, frame.inFlight, nullptr);
+        }
+        vkDestroyCommandPool(graphics.device, graphics.commandPool, nullptr);
+
 #ifdef DEBUG
     	PFN_vkDestroyDebugReportCallbackEXT vkDestroyDebugCallback = 
             (PFN_vkDestroyDebugReportCallbackEXT)vkGetInstanceProcAddr(
@@ -542,16 +1436,8 @@ namespace igfx::graphics {
         );
 #endif
 
-        for (VkImageView view : graphics.swapchainImageViews) {
-            vkDestroyImageView(graphics.device, view, nullptr);
-        }
-        std::free(graphics.swapchainImageViews);
-
-        vkDestroySwapchainKHR(graphics.device, graphics.swapchain, nullptr);
-
         vkDestroySurfaceKHR(graphics.instance, graphics.surface, nullptr);
         vkDestroyDevice(graphics.device, nullptr);
         vkDestroyInstance(graphics.instance, nullptr);
     }
 }
-
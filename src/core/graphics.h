@@ -2,18 +2,88 @@
 #include <vulkan/vulkan.h>
 #include <std/slice.h>
 
+#include "igfx/config.h"
+#include "core/rendergraph.h"
+#include "core/sprites.h"
+
 namespace igfx::graphics {
+    constexpr u32 framesInFlight = 2;
+
+    struct FrameResources {
+        VkCommandBuffer commandBuffer;
+        VkSemaphore imageAvailable;
+        VkFence inFlight;
+    };
+
+    // Config::dynamicResolution. Sprites are drawn into the top left
+    // `renderExtent` of `sceneTarget` (allocated at the maximum scale),
+    // blitted to the swapchain and text is drawn over that. The scale is
+    // adjusted from the GPU time of each frame, measured with timestamps.
+    struct DynamicResolution {
+        // Smoothed GPU time outside [low, high] x budget for this many
+        // frames changes the scale. Over budget reacts faster, a missed
+        // budget stutters while a low scale only blurs.
+        static constexpr f32 low = 0.80f;
+        static constexpr f32 high = 0.95f;
+        static constexpr u32 overFrames = 4;
+        static constexpr u32 underFrames = 30;
+        static constexpr f32 maxStep = 0.1f;
+
+        bool enabled;
+        f32 budget; // seconds
+        f32 minScale;
+        f32 maxScale;
+
+        f32 scale;
+        f32 gpuTime; // smoothed, seconds
+        u32 over;
+        u32 under;
+
+        VkQueryPool timestamps; // two per frame in flight
+        f32 timestampPeriod; // ns per tick
+        bool timed[framesInFlight]; // the frame's queries were written
+
+        ImageHandle sceneTarget;
+        Pass* scenePass;
+        VkExtent2D renderExtent;
+    };
+
     struct Graphics {
         VkInstance instance;
+        VkPhysicalDevice physicalDevice;
         VkDevice device;
         VkQueue presentQueue;
         VkQueue graphicsQueue;
+        u32 graphicsQueueFamilyIndex;
+        u32 presentQueueFamilyIndex;
         VkSurfaceKHR surface;
 
+        VkSurfaceFormatKHR swapchainSurfaceFormat;
+        VkPresentModeKHR swapchainPresentMode;
         VkFormat swapchainImageFormat;
         VkExtent2D swapchainExtent;
         VkSwapchainKHR swapchain;
+        std::Buf<VkImage> swapchainImages;
         std::Buf<VkImageView> swapchainImageViews;
+        std::Buf<VkSemaphore> renderFinished; // one per swapchain image
+        u32 requestedImageCount;
+
+        bool memoryBudget; // VK_EXT_memory_budget enabled
+        bool textureCompressionBC; // baked BC textures are sampled as is
+
+        // VK_KHR_present_wait pacing, see Config::lowLatency.
+        bool presentWait;
+        u64 presentId;
+        PFN_vkWaitForPresentKHR vkWaitForPresent;
+
+        VkCommandPool commandPool;
+        FrameResources frames[framesInFlight];
+        u32 frameIndex;
+
+        RenderGraph graph;
+        ImageHandle swapchainTarget;
+
+        DynamicResolution resolution;
 
 #ifdef DEBUG
         VkDebugReportCallbackEXT debugCallback;
@@ -22,6 +92,36 @@ namespace igfx::graphics {
 
     extern Graphics graphics;
 
-    void init();
+    struct Buffer {
+        VkBuffer buffer;
+        VkDeviceMemory memory;
+        void* mapped; // host visible buffers stay mapped
+        VkDeviceSize size;
+    };
+
+    // Creates the instance and picks the device, false when no device is
+    // suitable. Needs no window (only glfw initialized), so it runs on a
+    // job thread while the window is created.
+    bool initInstance();
+
+    // The rest, once `initInstance` succeeded and the window exists.
+    void init(Config const& config);
     void deinit();
+
+    // Records and presents one frame through the render graph.
+    void render(std::Slice<SpriteCommand> sprites);
+
+    u32 findMemoryType(u32 memoryTypeBits, VkMemoryPropertyFlags properties);
+
+    Buffer createBuffer(
+        VkDeviceSize size,
+        VkBufferUsageFlags usage,
+        VkMemoryPropertyFlags properties
+    );
+    void destroyBuffer(Buffer const& buffer);
+
+    // One-off command buffer for uploads at init, submitted and waited on
+    // by `endImmediate`.
+    VkCommandBuffer beginImmediate();
+    void endImmediate(VkCommandBuffer commandBuffer);
 }
@@ -0,0 +1,149 @@
+#include "core/jobs.h"
+#include "core/thread.h"
+
+namespace igfx::jobs {
+    struct Job {
+        JobFn fn;
+        void* userData;
+        u32 index;
+        Counter* counter;
+    };
+
+    struct Jobs {
+        static constexpr u32 queueCapacity = 4096;
+        static constexpr u32 maxWorkers = 64;
+
+        Job queue[queueCapacity];
+        u32 head;
+        u32 count;
+
+        thread::Mutex mutex;
+        thread::Condition available;
+        thread::Condition finished;
+
+        thread::Thread workers[maxWorkers];
+        u32 workerCount;
+        bool quit;
+    };
+
+    Jobs jobs;
+
+    // Expects the mutex to be held.
+    inline bool pop(Job* job) {
+        if (jobs.count == 0) return false;
+
+        *job = jobs.queue[jobs.head];
+        jobs.head = (jobs.head + 1) % Jobs::queueCapacity;
+        jobs.count--;
+        return true;
+    }
+
+    inline void run(Job job) {
+        job.fn(job.index, job.userData);
+
+        if (__atomic_sub_fetch(&job.counter->pending, 1, __ATOMIC_ACQ_REL) == 0) {
+            jobs.mutex.lock();
+            jobs.finished.broadcast();
+            jobs.mutex.unlock();
+        }
+    }
+
+    void workerMain(void*) {
+        for (;;) {
+            jobs.mutex.lock();
+            while (jobs.count == 0 && !jobs.quit) jobs.available.wait(&jobs.mutex);
+
+            Job job;
+            bool popped = pop(&job);
+            jobs.mutex.unlock();
+
+            if (!popped) return; // quit with an empty queue
+            run(job);
+        }
+    }
+
+    void init(u32 workerCount) {
+        if (workerCount == 0) workerCount = thread::cpuCount() - 1;
+        if (workerCount > Jobs::maxWorkers) workerCount = Jobs::maxWorkers;
+
+        jobs.head = 0;
+        jobs.count = 0;
+        jobs.quit = false;
+        jobs.workerCount = workerCount;
+
+        jobs.mutex.init();
+        jobs.available.init();
+        jobs.finished.init();
+
+        for (u32 i = 0; i < workerCount; i++) {
+            jobs.workers[i] = thread::spawn(workerMain, nullptr);
+        }
+
+        std::debug("jobs: {} workers", workerCount);
+    }
+
+    void deinit() {
+        jobs.mutex.lock();
+        jobs.quit = true;
+        jobs.available.broadcast();
+        jobs.mutex.unlock();
+
+        for (u32 i = 0; i < jobs.workerCount; i++) thread::join(jobs.workers[i]);
+
+        jobs.finished.deinit();
+        jobs.available.deinit();
+        jobs.mutex.deinit();
+    }
+
+    u32 workerCount() {
+        return jobs.workerCount;
+    }
+
+    void submit(JobFn fn, void* userData, u32 count, Counter* counter) {
+        __atomic_add_fetch(&counter->pending, count, __ATOMIC_ACQ_REL);
+
+        for (u32 i = 0; i < count; i++) {
+            jobs.mutex.lock();
+
+            // Full, make room by running the oldest job here.
+            while (jobs.count == Jobs::queueCapacity) {
+                Job job;
+                pop(&job);
+                jobs.mutex.unlock();
+
+                run(job);
+                jobs.mutex.lock();
+            }
+
+            u32 tail = (jobs.head + jobs.count) % Jobs::queueCapacity;
+            jobs.queue[tail] = {fn, userData, i, counter};
+            jobs.count++;
+
+            jobs.available.signal();
+            jobs.mutex.unlock();
+        }
+    }
+
+    void wait(Counter* counter) {
+        for (;;) {
+            if (done(counter)) return;
+
+            jobs.mutex.lock();
+
+            Job job;
+            if (pop(&job)) {
+                jobs.mutex.unlock();
+                run(job);
+                continue;
+            }
+
+            // Checked under the lock, the last job broadcasts holding it.
+            if (!done(counter)) jobs.finished.wait(&jobs.mutex);
+            jobs.mutex.unlock();
+        }
+    }
+
+    bool done(Counter* counter) {
+        return __atomic_load_n(&counter->pending, __ATOMIC_ACQUIRE) == 0;
+    }
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+namespace igfx::jobs {
+    using JobFn = void(*)(u32 index, void* userData);
+
+    // Number of jobs from a `submit` still running or queued.
+    struct Counter {
+        u32 pending = 0;
+    };
+
+    // `workerCount` of 0 uses one worker per cpu besides the calling thread.
+    void init(u32 workerCount = 0);
+    void deinit();
+
+    u32 workerCount();
+
+    // Queues `fn(i, userData)` for every `i` in [0, count).
+    void submit(JobFn fn, void* userData, u32 count, Counter* counter);
+
+    // Runs queued jobs on the calling thread until `counter` reaches zero.
+    void wait(Counter* counter);
+
+    bool done(Counter* counter);
+
+    inline void parallelFor(u32 count, JobFn fn, void* userData) {
+        Counter counter;
+        submit(fn, userData, count, &counter);
+        wait(&counter);
+    }
+}
@@ -0,0 +1,112 @@
+#include "core/pipelines.h"
+#include "core/graphics.h"
+#include "core/timer.h"
+#include "core/startup.h"
+
+namespace igfx::graphics {
+    inline u32 hash(PipelineKey key) {
+        u64 x = (u64)key.colorFormat | ((u64)key.blend << 32) | ((u64)key.sdf << 40);
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdull;
+        x ^= x >> 33;
+        return (u32)x;
+    }
+
+    void compileJob(u32, void* userData) {
+        PipelineCache::Entry* entry = (PipelineCache::Entry*)userData;
+        PipelineCache* owner = entry->owner;
+
+        u32 phase = startup::phase("pipeline compile");
+        f64 start = timer::now();
+        entry->pipeline = owner->compile(entry->key, owner->cache);
+        entry->compileTime = timer::now() - start;
+        startup::end(phase);
+
+        __atomic_store_n(&entry->state, PipelineCache::Ready, __ATOMIC_RELEASE);
+    }
+
+    void PipelineCache::init(PipelineCompileFn compile) {
+        for (Entry& entry : entries) entry.state = Empty;
+        count = 0;
+        this->compile = compile;
+
+        VkPipelineCacheCreateInfo createInfo {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+        };
+
+        if (vkCreatePipelineCache(
+            graphics.device,
+            &createInfo,
+            nullptr,
+            &cache
+        ) != VK_SUCCESS) std::fatal("failed to create pipeline cache");
+    }
+
+    void PipelineCache::deinit() {
+        for (Entry& entry : entries) {
+            if (__atomic_load_n(&entry.state, __ATOMIC_ACQUIRE) == Empty) continue;
+
+            jobs::wait(&entry.counter);
+            vkDestroyPipeline(graphics.device, entry.pipeline, nullptr);
+            entry.state = Empty;
+        }
+
+        vkDestroyPipelineCache(graphics.device, cache, nullptr);
+        count = 0;
+    }
+
+    // The entry for `key`, queued for compilation when it is new. Only
+    // the render thread inserts, jobs only publish their own entry.
+    PipelineCache::Entry* lookup(PipelineCache* cache, PipelineKey key) {
+        u32 mask = PipelineCache::capacity - 1;
+        for (u32 i = hash(key) & mask;; i = (i + 1) & mask) {
+            PipelineCache::Entry& entry = cache->entries[i];
+            if (__atomic_load_n(&entry.state, __ATOMIC_ACQUIRE) == PipelineCache::Empty) {
+                if (cache->count == PipelineCache::capacity - 1) {
+                    std::fatal("pipeline limit ({}) reached", PipelineCache::capacity - 1);
+                }
+
+                entry.key = key;
+                entry.state = PipelineCache::Compiling;
+                entry.pipeline = nullptr;
+                entry.owner = cache;
+                entry.counter = {};
+                cache->count++;
+
+                jobs::submit(compileJob, &entry, 1, &entry.counter);
+                return &entry;
+            }
+
+            if (entry.key == key) return &entry;
+        }
+    }
+
+    void PipelineCache::prepare(PipelineKey key) {
+        lookup(this, key);
+    }
+
+    VkPipeline PipelineCache::find(PipelineKey key) {
+        Entry* entry = lookup(this, key);
+        if (__atomic_load_n(&entry->state, __ATOMIC_ACQUIRE) != Ready) return nullptr;
+
+        return entry->pipeline;
+    }
+
+    VkPipeline PipelineCache::wait(PipelineKey key) {
+        Entry* entry = lookup(this, key);
+        if (__atomic_load_n(&entry->state, __ATOMIC_ACQUIRE) != Ready) {
+            f64 start = timer::now();
+            jobs::wait(&entry->counter);
+
+            std::debug(
+                "pipelines: waited {} ms for blend {}{} (compiled in {} ms)",
+                (timer::now() - start) * 1000.0,
+                (u32)key.blend,
+                key.sdf ? " sdf" : "",
+                entry->compileTime * 1000.0
+            );
+        }
+
+        return entry->pipeline;
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+#include "igfx/graphics.h"
+#include "core/jobs.h"
+
+// Graphics pipelines looked up by the compact state they differ in. A
+// missing pipeline is compiled on a job thread (vkCreateGraphicsPipelines
+// takes milliseconds) and used once ready, so a new state combination
+// never compiles inside a pass. Shader variants are specialization
+// constants chosen from the key, not separate shader sources.
+namespace igfx::graphics {
+    struct PipelineKey {
+        VkFormat colorFormat;
+        BlendMode blend;
+        bool sdf; // distance field text
+
+        bool operator==(PipelineKey const&) const = default;
+    };
+
+    // Creates the pipeline for `key` on a job thread, sharing `cache`.
+    using PipelineCompileFn = VkPipeline(*)(PipelineKey key, VkPipelineCache cache);
+
+    struct PipelineCache {
+        // Open addressing, a power of two.
+        static constexpr u32 capacity = 256;
+
+        // u32 for the atomic builtins.
+        enum State : u32 {
+            Empty,
+            Compiling,
+            Ready,
+        };
+
+        struct Entry {
+            PipelineKey key;
+            u32 state; // Compiling -> Ready is published by the job
+            VkPipeline pipeline;
+            f64 compileTime; // seconds
+            jobs::Counter counter;
+            PipelineCache* owner;
+        };
+
+        Entry entries[capacity];
+        u32 count;
+
+        PipelineCompileFn compile;
+        VkPipelineCache cache;
+
+        void init(PipelineCompileFn compile);
+        // Waits for compilations still running.
+        void deinit();
+
+        // Queues `key` for compilation unless it is known already.
+        void prepare(PipelineKey key);
+
+        // The pipeline for `key`, nullptr while it compiles (the first
+        // call queues it).
+        VkPipeline find(PipelineKey key);
+
+        // Like `find` but waits for the compilation, helping run jobs.
+        VkPipeline wait(PipelineKey key);
+    };
+}
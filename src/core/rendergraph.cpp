@@ -0,0 +1,536 @@
+#include "core/rendergraph.h"
+#include "core/graphics.h"
+
+#include <std/math.h>
+
+namespace igfx::graphics {
+    struct AccessInfo {
+        VkImageLayout layout;
+        VkPipelineStageFlags2 stage;
+        VkAccessFlags2 access;
+    };
+
+    inline AccessInfo accessInfo(Access access) {
+        switch (access) {
+        // The stage of `None` chains with the swapchain acquire semaphore
+        // which is waited on at COLOR_ATTACHMENT_OUTPUT.
+        case Access::None: return {
+            VK_IMAGE_LAYOUT_UNDEFINED,
+            VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+            VK_ACCESS_2_NONE,
+        };
+        case Access::ColorAttachment: return {
+            VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+            VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+            VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+        };
+        case Access::ShaderRead: return {
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+            VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+        };
+        case Access::TransferSrc: return {
+            VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+            VK_ACCESS_2_TRANSFER_READ_BIT,
+        };
+        case Access::TransferDst: return {
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+            VK_ACCESS_2_TRANSFER_WRITE_BIT,
+        };
+        case Access::Present: return {
+            VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+            VK_PIPELINE_STAGE_2_NONE,
+            VK_ACCESS_2_NONE,
+        };
+        }
+
+        return {};
+    }
+
+    inline bool isWrite(Access access) {
+        return access == Access::ColorAttachment || access == Access::TransferDst;
+    }
+
+    void Pass::read(ImageHandle image, Access access) {
+        if (accessCount == maxAccesses) std::fatal("pass '{}' has too many accesses", name);
+        accesses[accessCount++] = {image.index, access, false};
+    }
+
+    void Pass::write(ImageHandle image, Access access) {
+        if (accessCount == maxAccesses) std::fatal("pass '{}' has too many accesses", name);
+        accesses[accessCount++] = {image.index, access, true};
+    }
+
+    void Pass::color(
+        ImageHandle image,
+        VkAttachmentLoadOp loadOp,
+        VkClearColorValue clearColor
+    ) {
+        if (loadOp == VK_ATTACHMENT_LOAD_OP_LOAD) read(image, Access::ColorAttachment);
+        write(image, Access::ColorAttachment);
+
+        this->colorAttachment = image.index;
+        this->loadOp = loadOp;
+        this->clearColor = clearColor;
+    }
+
+    void RenderGraph::reset() {
+        passCount = 0;
+        imageCount = 0;
+        slotCount = 0;
+    }
+
+    ImageHandle RenderGraph::importImage(
+        ImageDesc desc,
+        Access initialAccess,
+        Access finalAccess,
+        bool output
+    ) {
+        if (imageCount == maxImages) std::fatal("render graph image limit reached");
+
+        images[imageCount] = {
+            .desc = desc,
+            .image = nullptr,
+            .view = nullptr,
+            .transient = false,
+            .output = output,
+            .initialAccess = initialAccess,
+            .finalAccess = finalAccess,
+        };
+
+        return {imageCount++};
+    }
+
+    ImageHandle RenderGraph::createImage(ImageDesc desc) {
+        if (imageCount == maxImages) std::fatal("render graph image limit reached");
+
+        images[imageCount] = {
+            .desc = desc,
+            .image = nullptr,
+            .view = nullptr,
+            .transient = true,
+            .output = false,
+            .initialAccess = Access::None,
+            .finalAccess = Access::None,
+        };
+
+        return {imageCount++};
+    }
+
+    void RenderGraph::setImage(ImageHandle handle, VkImage image, VkImageView view) {
+        images[handle.index].image = image;
+        images[handle.index].view = view;
+    }
+
+    Pass& RenderGraph::addPass(u8 const name[], PassFn fn, void* userData) {
+        if (passCount == maxPasses) std::fatal("render graph pass limit reached");
+
+        passes[passCount] = {
+            .name = name,
+            .fn = fn,
+            .userData = userData,
+            .accessCount = 0,
+            .colorAttachment = ImageHandle::invalid,
+            .renderArea = {},
+        };
+
+        return passes[passCount++];
+    }
+
+    void RenderGraph::cull() {
+        // Walking backwards from the outputs. A pass is alive if it writes
+        // something a later alive pass (or the output) still needs, a plain
+        // write then satisfies the need so earlier writers die.
+        bool needed[maxImages];
+        for (u32 i = 0; i < imageCount; i++) needed[i] = images[i].output;
+
+        for (u32 p = passCount; p-- > 0;) {
+            Pass& pass = passes[p];
+
+            alive[p] = false;
+            for (u32 a = 0; a < pass.accessCount; a++) {
+                if (pass.accesses[a].write && needed[pass.accesses[a].image]) {
+                    alive[p] = true;
+                }
+            }
+
+            if (!alive[p]) {
+                std::debug("render graph: culled pass '{}'", pass.name);
+                continue;
+            }
+
+            for (u32 a = 0; a < pass.accessCount; a++) {
+                if (pass.accesses[a].write) needed[pass.accesses[a].image] = false;
+            }
+
+            for (u32 a = 0; a < pass.accessCount; a++) {
+                if (!pass.accesses[a].write) needed[pass.accesses[a].image] = true;
+            }
+        }
+
+        // Lifetimes.
+        for (u32 i = 0; i < imageCount; i++) {
+            images[i].firstPass = ImageHandle::invalid;
+            images[i].lastPass = 0;
+            images[i].memorySlot = ImageHandle::invalid;
+            images[i].previous = ImageHandle::invalid;
+        }
+
+        for (u32 p = 0; p < passCount; p++) {
+            if (!alive[p]) continue;
+
+            Pass& pass = passes[p];
+            for (u32 a = 0; a < pass.accessCount; a++) {
+                Image& image = images[pass.accesses[a].image];
+                if (image.firstPass == ImageHandle::invalid) image.firstPass = p;
+                image.lastPass = p;
+            }
+        }
+    }
+
+    void RenderGraph::assignSlots(VkMemoryRequirements const requirements[]) {
+        // Transient images in order of first use, each one reuses the first
+        // memory slot whose previous occupant is already dead.
+        u32 order[maxImages];
+        u32 orderCount = 0;
+        for (u32 i = 0; i < imageCount; i++) {
+            if (!images[i].transient || images[i].firstPass == ImageHandle::invalid) continue;
+
+            u32 j = orderCount++;
+            for (; j > 0 && images[order[j - 1]].firstPass > images[i].firstPass; j--) {
+                order[j] = order[j - 1];
+            }
+            order[j] = i;
+        }
+
+        slotCount = 0;
+        for (u32 o = 0; o < orderCount; o++) {
+            Image& image = images[order[o]];
+            VkMemoryRequirements const& imageRequirements = requirements[order[o]];
+
+            u32 s = 0;
+            for (; s < slotCount; s++) {
+                if (
+                    slots[s].lastPass < image.firstPass
+                    && (slots[s].memoryTypeBits & imageRequirements.memoryTypeBits) != 0
+                ) break;
+            }
+
+            if (s == slotCount) {
+                slots[slotCount++] = {
+                    .memory = nullptr,
+                    .size = 0,
+                    .memoryTypeBits = imageRequirements.memoryTypeBits,
+                };
+            } else {
+                image.previous = slots[s].lastOccupant;
+            }
+
+            MemorySlot& slot = slots[s];
+            slot.size = std::max(slot.size, imageRequirements.size);
+            slot.memoryTypeBits &= imageRequirements.memoryTypeBits;
+            slot.lastPass = image.lastPass;
+            slot.lastOccupant = order[o];
+
+            image.memorySlot = s;
+        }
+    }
+
+    void RenderGraph::planBarriers() {
+        // At most one batch in front of every alive pass plus a final batch
+        // moving imported images into their final access.
+        Access state[maxImages];
+        bool touched[maxImages];
+        for (u32 i = 0; i < imageCount; i++) {
+            state[i] = images[i].initialAccess;
+            touched[i] = false;
+        }
+
+        u32 barrierCount = 0;
+        for (u32 p = 0; p < passCount; p++) {
+            barrierOffsets[p] = barrierCount;
+            if (!alive[p]) continue;
+
+            Pass& pass = passes[p];
+            u32 passBarriers = barrierCount;
+            for (u32 a = 0; a < pass.accessCount; a++) {
+                u32 i = pass.accesses[a].image;
+                Access access = pass.accesses[a].access;
+
+                bool duplicate = false;
+                for (u32 b = passBarriers; b < barrierCount; b++) {
+                    if (barriers[b].image == i) duplicate = true;
+                }
+                if (duplicate) continue;
+
+                if (!touched[i]) {
+                    touched[i] = true;
+
+                    if (images[i].transient) {
+                        Access src = Access::None;
+                        if (images[i].previous != ImageHandle::invalid) {
+                            src = state[images[i].previous];
+                        }
+
+                        barriers[barrierCount++] = {i, src, access, true};
+                        state[i] = access;
+                        continue;
+                    }
+
+                    if (state[i] == Access::None) {
+                        barriers[barrierCount++] = {i, Access::None, access, true};
+                        state[i] = access;
+                        continue;
+                    }
+                }
+
+                // Read after read in the same layout needs nothing.
+                if (state[i] == access && !isWrite(access)) continue;
+
+                barriers[barrierCount++] = {i, state[i], access, false};
+                state[i] = access;
+            }
+        }
+
+        // The first occupant of a slot follows its last occupant from the
+        // previous frame, which may still be in flight on the same queue.
+        for (u32 b = 0; b < barrierCount; b++) {
+            Image& image = images[barriers[b].image];
+            if (!barriers[b].discard || !image.transient) continue;
+            if (image.previous != ImageHandle::invalid) continue;
+
+            barriers[b].src = state[slots[image.memorySlot].lastOccupant];
+        }
+
+        barrierOffsets[passCount] = barrierCount;
+        for (u32 i = 0; i < imageCount; i++) {
+            if (
+                images[i].transient
+                || images[i].finalAccess == Access::None
+                || images[i].finalAccess == state[i]
+            ) continue;
+
+            barriers[barrierCount++] = {i, state[i], images[i].finalAccess, !touched[i]};
+        }
+
+        barrierOffsets[passCount + 1] = barrierCount;
+    }
+
+    void RenderGraph::compile() {
+        cull();
+
+        VkMemoryRequirements requirements[maxImages];
+        VkDeviceSize requestedBytes = 0;
+        u32 transientCount = 0;
+        for (u32 i = 0; i < imageCount; i++) {
+            Image& image = images[i];
+            if (!image.transient || image.firstPass == ImageHandle::invalid) continue;
+
+            VkImageCreateInfo imageCreateInfo {
+                .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+                .imageType = VK_IMAGE_TYPE_2D,
+                .format = image.desc.format,
+                .extent = {image.desc.extent.width, image.desc.extent.height, 1},
+                .mipLevels = 1,
+                .arrayLayers = 1,
+                .samples = VK_SAMPLE_COUNT_1_BIT,
+                .tiling = VK_IMAGE_TILING_OPTIMAL,
+                .usage = image.desc.usage,
+                .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+                .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+            };
+
+            if (vkCreateImage(
+                graphics.device,
+                &imageCreateInfo,
+                nullptr,
+                &image.image
+            ) != VK_SUCCESS) std::fatal("failed to create transient image");
+
+            vkGetImageMemoryRequirements(graphics.device, image.image, &requirements[i]);
+            requestedBytes += requirements[i].size;
+            transientCount++;
+        }
+
+        assignSlots(requirements);
+
+        VkDeviceSize allocatedBytes = 0;
+        for (u32 s = 0; s < slotCount; s++) {
+            VkMemoryAllocateInfo allocateInfo {
+                .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+                .allocationSize = slots[s].size,
+                .memoryTypeIndex = findMemoryType(
+                    slots[s].memoryTypeBits,
+                    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+                ),
+            };
+
+            if (vkAllocateMemory(
+                graphics.device,
+                &allocateInfo,
+                nullptr,
+                &slots[s].memory
+            ) != VK_SUCCESS) std::fatal("failed to allocate transient image memory");
+
+            allocatedBytes += slots[s].size;
+        }
+
+        for (u32 i = 0; i < imageCount; i++) {
+            Image& image = images[i];
+            if (image.memorySlot == ImageHandle::invalid) continue;
+
+            vkBindImageMemory(
+                graphics.device,
+                image.image,
+                slots[image.memorySlot].memory,
+                0
+            );
+
+            VkImageViewCreateInfo viewCreateInfo {
+                .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+                .image = image.image,
+                .viewType = VK_IMAGE_VIEW_TYPE_2D,
+                .format = image.desc.format,
+                .subresourceRange = {
+                    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                    .baseMipLevel = 0,
+                    .levelCount = 1,
+                    .baseArrayLayer = 0,
+                    .layerCount = 1,
+                },
+            };
+
+            if (vkCreateImageView(
+                graphics.device,
+                &viewCreateInfo,
+                nullptr,
+                &image.view
+            ) != VK_SUCCESS) std::fatal("failed to create transient image view");
+        }
+
+        if (transientCount > 0) {
+            std::debug(
+                "render graph: {} transient images, {} KiB requested, {} KiB allocated",
+                transientCount,
+                requestedBytes / 1024,
+                allocatedBytes / 1024
+            );
+        }
+
+        planBarriers();
+    }
+
+    inline void recordBarriers(
+        RenderGraph* graph,
+        VkCommandBuffer commandBuffer,
+        u32 begin,
+        u32 end
+    ) {
+        if (begin == end) return;
+
+        VkImageMemoryBarrier2 imageBarriers[RenderGraph::maxImages];
+        u32 count = 0;
+        for (u32 b = begin; b < end; b++) {
+            RenderGraph::Barrier barrier = graph->barriers[b];
+            AccessInfo src = accessInfo(barrier.src);
+            AccessInfo dst = accessInfo(barrier.dst);
+
+            imageBarriers[count++] = {
+                .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+                .srcStageMask = src.stage,
+                .srcAccessMask = src.access,
+                .dstStageMask = dst.stage,
+                .dstAccessMask = dst.access,
+                .oldLayout = barrier.discard ? VK_IMAGE_LAYOUT_UNDEFINED : src.layout,
+                .newLayout = dst.layout,
+                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .image = graph->images[barrier.image].image,
+                .subresourceRange = {
+                    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                    .baseMipLevel = 0,
+                    .levelCount = 1,
+                    .baseArrayLayer = 0,
+                    .layerCount = 1,
+                },
+            };
+        }
+
+        VkDependencyInfo dependencyInfo {
+            .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+            .imageMemoryBarrierCount = count,
+            .pImageMemoryBarriers = imageBarriers,
+        };
+
+        vkCmdPipelineBarrier2(commandBuffer, &dependencyInfo);
+    }
+
+    void RenderGraph::execute(VkCommandBuffer commandBuffer) {
+        for (u32 p = 0; p < passCount; p++) {
+            if (!alive[p]) continue;
+
+            recordBarriers(this, commandBuffer, barrierOffsets[p], barrierOffsets[p + 1]);
+
+            Pass& pass = passes[p];
+            PassContext context {
+                .commandBuffer = commandBuffer,
+                .extent = graphics.swapchainExtent,
+                .graph = this,
+            };
+
+            if (pass.colorAttachment == ImageHandle::invalid) {
+                pass.fn(&context, pass.userData);
+                continue;
+            }
+
+            Image& target = images[pass.colorAttachment];
+            context.extent = pass.renderArea.width != 0 ? pass.renderArea : target.desc.extent;
+
+            VkRenderingAttachmentInfo colorAttachment {
+                .sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
+                .imageView = target.view,
+                .imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                .loadOp = pass.loadOp,
+                .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+                .clearValue = {.color = pass.clearColor},
+            };
+
+            VkRenderingInfo renderingInfo {
+                .sType = VK_STRUCTURE_TYPE_RENDERING_INFO,
+                .renderArea = {{0, 0}, context.extent},
+                .layerCount = 1,
+                .colorAttachmentCount = 1,
+                .pColorAttachments = &colorAttachment,
+            };
+
+            vkCmdBeginRendering(commandBuffer, &renderingInfo);
+            pass.fn(&context, pass.userData);
+            vkCmdEndRendering(commandBuffer);
+        }
+
+        recordBarriers(
+            this,
+            commandBuffer,
+            barrierOffsets[passCount],
+            barrierOffsets[passCount + 1]
+        );
+    }
+
+    void RenderGraph::deinit() {
+        for (u32 i = 0; i < imageCount; i++) {
+            Image& image = images[i];
+            if (!image.transient || image.image == nullptr) continue;
+
+            vkDestroyImageView(graphics.device, image.view, nullptr);
+            vkDestroyImage(graphics.device, image.image, nullptr);
+        }
+
+        for (u32 s = 0; s < slotCount; s++) {
+            vkFreeMemory(graphics.device, slots[s].memory, nullptr);
+        }
+
+        reset();
+    }
+}
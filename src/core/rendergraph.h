@@ -0,0 +1,162 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+namespace igfx::graphics {
+    // How a pass touches an image, each one maps to a fixed layout, stage and
+    // access mask so barriers can be derived without the pass spelling them out.
+    enum class Access : u8 {
+        None,
+        ColorAttachment,
+        ShaderRead,
+        TransferSrc,
+        TransferDst,
+        Present,
+    };
+
+    struct ImageHandle {
+        static constexpr u32 invalid = 0xffffffff;
+        u32 index = invalid;
+    };
+
+    struct ImageDesc {
+        VkFormat format;
+        VkExtent2D extent;
+        VkImageUsageFlags usage;
+    };
+
+    struct RenderGraph;
+    struct PassContext {
+        VkCommandBuffer commandBuffer;
+        VkExtent2D extent;
+        RenderGraph* graph;
+    };
+
+    using PassFn = void(*)(PassContext*, void* userData);
+
+    struct Pass {
+        static constexpr u32 maxAccesses = 8;
+        struct ImageAccess {
+            u32 image;
+            Access access;
+            bool write;
+        };
+
+        u8 const* name;
+        PassFn fn;
+        void* userData;
+
+        ImageAccess accesses[maxAccesses];
+        u32 accessCount;
+
+        u32 colorAttachment;
+        VkAttachmentLoadOp loadOp;
+        VkClearColorValue clearColor;
+        // Top left part of the attachment rendered, all of it when zero.
+        // May change every frame (dynamic resolution).
+        VkExtent2D renderArea;
+
+        void read(ImageHandle, Access);
+        void write(ImageHandle, Access);
+
+        // Renders into `image` inside vkCmdBeginRendering/vkCmdEndRendering,
+        // a load op other than CLEAR/DONT_CARE counts as a read.
+        void color(
+            ImageHandle image,
+            VkAttachmentLoadOp loadOp,
+            VkClearColorValue clearColor = {}
+        );
+    };
+
+    // A frame graph built once (and rebuilt when the swapchain changes) and
+    // executed every frame. `compile` culls passes that don't contribute to
+    // an output image, places transient images with disjoint lifetimes in the
+    // same memory and precomputes one batched barrier per pass.
+    struct RenderGraph {
+        static constexpr u32 maxPasses = 32;
+        static constexpr u32 maxImages = 32;
+
+        struct Image {
+            ImageDesc desc;
+            VkImage image;
+            VkImageView view;
+            bool transient;
+            bool output;
+
+            Access initialAccess;
+            Access finalAccess;
+
+            u32 firstPass;
+            u32 lastPass;
+            u32 memorySlot;
+            u32 previous; // image that occupied the memory slot before this one
+        };
+
+        struct Barrier {
+            u32 image;
+            Access src;
+            Access dst;
+            bool discard; // old contents are undefined (first use or aliased)
+        };
+
+        struct MemorySlot {
+            VkDeviceMemory memory;
+            VkDeviceSize size;
+            u32 memoryTypeBits;
+            u32 lastPass;
+            u32 lastOccupant; // image, the next frame's first one follows it
+        };
+
+        Pass passes[maxPasses];
+        u32 passCount;
+
+        Image images[maxImages];
+        u32 imageCount;
+
+        // Barriers are stored flat, pass `i` owns barriers
+        // [barrierOffsets[i], barrierOffsets[i + 1]).
+        Barrier barriers[maxPasses * Pass::maxAccesses + maxImages];
+        u32 barrierOffsets[maxPasses + 2];
+
+        bool alive[maxPasses];
+
+        MemorySlot slots[maxImages];
+        u32 slotCount;
+
+        void reset();
+
+        // `initialAccess` of Access::None discards the previous contents.
+        ImageHandle importImage(
+            ImageDesc desc,
+            Access initialAccess,
+            Access finalAccess,
+            bool output
+        );
+        ImageHandle createImage(ImageDesc desc);
+
+        // Imported images (e.g. the swapchain) may change every frame.
+        void setImage(ImageHandle, VkImage, VkImageView);
+
+        VkImage image(ImageHandle handle) const {
+            return images[handle.index].image;
+        }
+
+        VkImageView view(ImageHandle handle) const {
+            return images[handle.index].view;
+        }
+
+        Pass& addPass(u8 const name[], PassFn fn, void* userData);
+
+        void compile();
+
+        // The steps of `compile` that don't touch the device. `assignSlots`
+        // takes the memory requirements of every image by index.
+        void cull();
+        void assignSlots(VkMemoryRequirements const requirements[]);
+        void planBarriers();
+
+        void execute(VkCommandBuffer commandBuffer);
+
+        // Destroys transient images and their memory.
+        void deinit();
+    };
+}
@@ -0,0 +1,434 @@
+#include "core/software.h"
+#include "core/textures.h"
+#include "core/text.h"
+#include "core/jobs.h"
+
+#include <std/alloc.h>
+#include <std/math.h>
+
+namespace igfx::software {
+    Framebuffer framebuffer;
+
+    // A sprite quad, `x0..y1` is the covered pixel bounding box. Rotated
+    // quads are tested per row against their center and half extents.
+    struct Rect {
+        u32 x0, y0;
+        u32 x1, y1;
+        u32 color;
+        BlendMode blend;
+
+        bool rotated;
+        f32 cx, cy;
+        f32 hx, hy;
+        f32 cos, sin;
+
+        // Nearest texel sampling, nullptr fills with `color`. Texel
+        // coordinates are 16.16 fixed point linear in the pixel position,
+        // u = u0 + x * dux + y * duy, so tiles agree on shared rows.
+        u8 const* texels; // RGBA8, or R8 distances for glyphs
+        u32 texWidth, texHeight;
+        i64 u0, dux, duy;
+        i64 v0, dvx, dvy;
+        bool sdf;
+        i32 sdfGain; // distance to coverage slope, 8.8
+    };
+
+    struct Software {
+        u32 tilesX;
+        u32 tilesY;
+
+        std::Buf<Rect> rects;
+        std::Buf<u32> binOffsets; // tilesX * tilesY + 1
+        std::Buf<u32> bins;
+    };
+
+    Software software;
+
+    constexpr u32 clearColor = 0xff000000;
+
+    inline u32 rgba(u32 r, u32 g, u32 b, u32 a) {
+        return r | (g << 8) | (b << 16) | (a << 24);
+    }
+
+    // Pixel (x, y) is covered when its center lies in [min, max).
+    inline u32 coverage(f32 v, u32 limit) {
+        f32 c = __builtin_ceilf(v - 0.5f);
+        if (c <= 0.0f) return 0;
+        if (c >= (f32)limit) return limit;
+        return (u32)c;
+    }
+
+    // Narrows [lo, hi) to the offsets d where |k * d + m| < h.
+    inline void slab(f32 k, f32 m, f32 h, f32* lo, f32* hi) {
+        if (__builtin_fabsf(k) < 1e-6f) {
+            if (__builtin_fabsf(m) >= h) *hi = *lo;
+            return;
+        }
+
+        f32 a = (-h - m) / k;
+        f32 b = (h - m) / k;
+        *lo = std::max(*lo, std::min(a, b));
+        *hi = std::min(*hi, std::max(a, b));
+    }
+
+    // The covered pixels of row `y` in [*x0, *x1).
+    inline void rowSpan(Rect const& rect, u32 y, u32* x0, u32* x1) {
+        if (!rect.rotated) return;
+
+        // Pixel centers relative to the quad center, in its local frame
+        // lx = cos * dx + sin * dy and ly = cos * dy - sin * dx.
+        f32 dy = (f32)y + 0.5f - rect.cy;
+        f32 lo = -1e30f, hi = 1e30f;
+        slab(rect.cos, rect.sin * dy, rect.hx, &lo, &hi);
+        slab(-rect.sin, rect.cos * dy, rect.hy, &lo, &hi);
+
+        if (lo >= hi) {
+            *x1 = *x0;
+            return;
+        }
+
+        *x0 = std::max(*x0, coverage(rect.cx + lo, framebuffer.width));
+        *x1 = std::min(*x1, coverage(rect.cx + hi, framebuffer.width));
+    }
+
+    template <typename T>
+    inline void reserve(std::Buf<T>* buf, usize count) {
+        if (buf->len >= count) return;
+
+        usize capacity = std::max(count, buf->len * 2);
+        if (buf->len > 0) std::free(*buf);
+        *buf = std::alloc<T>(capacity);
+    }
+
+    // dst = src * a + dst * (1 - a) in 8 bit fixed point, the alpha channel
+    // of `src` is treated as 255 so coverage accumulates like source-over.
+    inline u16 blendChannel(u16 s, u16 d, u16 a) {
+        u16 x = s * a + d * (255 - a) + 128;
+        return (x + 1 + (x >> 8)) >> 8;
+    }
+
+    // unsigned char, u8 is a plain char and would sign extend when widened.
+    using u8x16 = unsigned char __attribute__((ext_vector_type(16)));
+    using u16x16 = u16 __attribute__((ext_vector_type(16)));
+
+    void fillSpan(u32* dst, u32 count, u32 color) {
+        u16 a = color >> 24;
+        if (a == 255) {
+            for (u32 i = 0; i < count; i++) dst[i] = color;
+            return;
+        }
+
+        u16 channels[4] = {
+            (u16)(color & 0xff),
+            (u16)((color >> 8) & 0xff),
+            (u16)((color >> 16) & 0xff),
+            255,
+        };
+
+        u16x16 src;
+        for (u32 i = 0; i < 16; i++) src[i] = channels[i % 4] * a + 128;
+        u16x16 inv = (u16)(255 - a);
+
+        // Four pixels at a time, the same arithmetic as blendChannel.
+        u32 i = 0;
+        for (; i + 4 <= count; i += 4) {
+            u8x16 bytes;
+            __builtin_memcpy(&bytes, dst + i, sizeof(bytes));
+
+            u16x16 x = src + __builtin_convertvector(bytes, u16x16) * inv;
+            x = (x + 1 + (x >> 8)) >> 8;
+
+            bytes = __builtin_convertvector(x, u8x16);
+            __builtin_memcpy(dst + i, &bytes, sizeof(bytes));
+        }
+
+        for (; i < count; i++) {
+            u32 d = dst[i];
+            dst[i] = rgba(
+                blendChannel(channels[0], d & 0xff, a),
+                blendChannel(channels[1], (d >> 8) & 0xff, a),
+                blendChannel(channels[2], (d >> 16) & 0xff, a),
+                blendChannel(channels[3], d >> 24, a)
+            );
+        }
+    }
+
+    // The non source-over modes, matching the Vulkan blend states: additive
+    // adds src * a, multiply scales by src faded to white by a.
+    void blendSpan(u32* dst, u32 count, u32 color, BlendMode blend) {
+        if (blend == BlendMode::Alpha) {
+            fillSpan(dst, count, color);
+            return;
+        }
+
+        u32 a = color >> 24;
+        u32 channels[3];
+        for (u32 c = 0; c < 3; c++) {
+            u32 s = (color >> (c * 8)) & 0xff;
+            channels[c] = blend == BlendMode::Additive
+                ? (s * a + 127) / 255
+                : (s * a + 255 * (255 - a) + 127) / 255;
+        }
+
+        for (u32 i = 0; i < count; i++) {
+            u32 d = dst[i];
+            u32 result = d & 0xff000000;
+            for (u32 c = 0; c < 3; c++) {
+                u32 channel = (d >> (c * 8)) & 0xff;
+                channel = blend == BlendMode::Additive
+                    ? std::min(channel + channels[c], 255u)
+                    : (channel * channels[c] + 127) / 255;
+                result |= channel << (c * 8);
+            }
+
+            dst[i] = result;
+        }
+    }
+
+    inline u32 modulate(u32 a, u32 b) {
+        u32 result = 0;
+        for (u32 c = 0; c < 32; c += 8) {
+            result |= ((((a >> c) & 0xff) * ((b >> c) & 0xff) + 127) / 255) << c;
+        }
+        return result;
+    }
+
+    // Pixels [x, x + count) of row `y`, each blended on its own.
+    void texturedSpan(u32* dst, u32 x, u32 y, u32 count, Rect const& rect) {
+        for (u32 i = 0; i < count; i++) {
+            i64 px = x + i;
+            i64 u = (rect.u0 + px * rect.dux + (i64)y * rect.duy) >> 16;
+            i64 v = (rect.v0 + px * rect.dvx + (i64)y * rect.dvy) >> 16;
+            u32 tx = (u32)std::clamp(u, (i64)0, (i64)rect.texWidth - 1);
+            u32 ty = (u32)std::clamp(v, (i64)0, (i64)rect.texHeight - 1);
+
+            u32 color;
+            if (rect.sdf) {
+                i32 distance = (unsigned char)rect.texels[ty * rect.texWidth + tx];
+                i32 coverage = std::clamp((distance - 128) * rect.sdfGain / 256 + 128, 0, 255);
+                u32 a = ((rect.color >> 24) * (u32)coverage + 127) / 255;
+                color = (rect.color & 0x00ffffff) | (a << 24);
+            } else {
+                u32 texel;
+                __builtin_memcpy(&texel, rect.texels + (ty * rect.texWidth + tx) * 4, sizeof(texel));
+                color = modulate(texel, rect.color);
+            }
+
+            if ((color >> 24) == 0) continue;
+            blendSpan(dst + i, 1, color, rect.blend);
+        }
+    }
+
+    // What `sprite` samples, false to fill it flat (the default white
+    // texture, or one still loading).
+    bool texelSource(graphics::SpriteInfo const& sprite, Rect* rect) {
+        if (sprite.sdf) {
+            if (graphics::text.pixels.len == 0) return false;
+
+            rect->texels = graphics::text.pixels.ptr;
+            rect->texWidth = graphics::Text::atlasSize;
+            rect->texHeight = graphics::Text::atlasSize;
+            rect->sdf = true;
+            return true;
+        }
+
+        if (sprite.texture == 0 || sprite.texture >= graphics::textures.count) return false;
+
+        graphics::Texture const& texture = graphics::textures.entries[sprite.texture];
+        if (texture.external || __atomic_load_n(&texture.loading, __ATOMIC_ACQUIRE)) return false;
+        // Host copies are RGBA8 here, nothing is sampled by a device.
+        if (texture.format != texfile::Format::RGBA8 || texture.data.len == 0) return false;
+
+        rect->texels = texture.data.ptr;
+        rect->texWidth = texture.width;
+        rect->texHeight = texture.height;
+        return true;
+    }
+
+    // Maps pixel centers to texels through the sprite's uv rectangle, with
+    // w and h its signed size on screen.
+    void mapTexels(graphics::SpriteInfo const& sprite, f32 w, f32 h, Rect* rect) {
+        f64 uvU0 = sprite.uv[0] / 65535.0, uvU1 = sprite.uv[2] / 65535.0;
+        f64 uvV0 = sprite.uv[1] / 65535.0, uvV1 = sprite.uv[3] / 65535.0;
+
+        f64 su = rect->texWidth * (uvU1 - uvU0) / w;
+        f64 sv = rect->texHeight * (uvV1 - uvV0) / h;
+        f64 cos = rect->cos, sin = rect->sin;
+        f64 dx = 0.5 - rect->cx, dy = 0.5 - rect->cy;
+
+        // Local (unrotated) offsets lx = cos dx + sin dy, ly = cos dy - sin dx.
+        f64 u0 = rect->texWidth * (uvU0 + uvU1) * 0.5 + su * (cos * dx + sin * dy);
+        f64 v0 = rect->texHeight * (uvV0 + uvV1) * 0.5 + sv * (cos * dy - sin * dx);
+
+        rect->u0 = (i64)(u0 * 65536.0);
+        rect->dux = (i64)(su * cos * 65536.0);
+        rect->duy = (i64)(su * sin * 65536.0);
+        rect->v0 = (i64)(v0 * 65536.0);
+        rect->dvx = (i64)(-sv * sin * 65536.0);
+        rect->dvy = (i64)(sv * cos * 65536.0);
+
+        // Ramps over about a pixel like the shader, distances span
+        // 2 * spread atlas pixels over [0, 255].
+        if (rect->sdf) {
+            f64 width = std::max(0.75 * 255.0 * __builtin_fabs(su) / (2.0 * graphics::Text::spread), 1.0);
+            rect->sdfGain = (i32)(256.0 * 255.0 / (2.0 * width));
+        }
+    }
+
+    void rasterTile(u32 tile, void*) {
+        u32 tx0 = (tile % software.tilesX) * tileSize;
+        u32 ty0 = (tile / software.tilesX) * tileSize;
+        u32 tx1 = std::min(tx0 + tileSize, framebuffer.width);
+        u32 ty1 = std::min(ty0 + tileSize, framebuffer.height);
+
+        for (u32 y = ty0; y < ty1; y++) {
+            fillSpan(&framebuffer.pixels[y * framebuffer.width + tx0], tx1 - tx0, clearColor);
+        }
+
+        for (u32 b = software.binOffsets[tile]; b < software.binOffsets[tile + 1]; b++) {
+            Rect rect = software.rects[software.bins[b]];
+
+            u32 x0 = std::max(rect.x0, tx0);
+            u32 x1 = std::min(rect.x1, tx1);
+            u32 y0 = std::max(rect.y0, ty0);
+            u32 y1 = std::min(rect.y1, ty1);
+
+            for (u32 y = y0; y < y1; y++) {
+                u32 sx0 = x0, sx1 = x1;
+                rowSpan(rect, y, &sx0, &sx1);
+                if (sx0 >= sx1) continue;
+
+                if (rect.texels != nullptr) {
+                    u32* dst = &framebuffer.pixels[y * framebuffer.width + sx0];
+                    texturedSpan(dst, sx0, y, sx1 - sx0, rect);
+                    continue;
+                }
+
+                blendSpan(
+                    &framebuffer.pixels[y * framebuffer.width + sx0],
+                    sx1 - sx0,
+                    rect.color,
+                    rect.blend
+                );
+            }
+        }
+    }
+
+    void init(u32 width, u32 height) {
+        framebuffer = {
+            .width = width,
+            .height = height,
+            .pixels = std::alloc<u32>(width * height),
+        };
+
+        software = {
+            .tilesX = (width + tileSize - 1) / tileSize,
+            .tilesY = (height + tileSize - 1) / tileSize,
+        };
+
+        software.binOffsets = std::alloc<u32>(software.tilesX * software.tilesY + 1);
+        std::debug(
+            "software backend: {}x{}, {} tiles, {} workers",
+            width,
+            height,
+            software.tilesX * software.tilesY,
+            jobs::workerCount()
+        );
+    }
+
+    void deinit() {
+        if (software.rects.len > 0) std::free(software.rects);
+        if (software.bins.len > 0) std::free(software.bins);
+        std::free(software.binOffsets);
+        std::free(framebuffer.pixels);
+    }
+
+    void render(std::Slice<graphics::SpriteCommand> commands) {
+        u32 tileCount = software.tilesX * software.tilesY;
+        reserve(&software.rects, commands.len);
+
+        for (u32 t = 0; t <= tileCount; t++) software.binOffsets[t] = 0;
+
+        // Setup and counting, bins hold command indices so every tile walks
+        // its sprites in submission order.
+        for (u32 i = 0; i < commands.len; i++) {
+            graphics::SpriteCommand command = commands[i];
+            graphics::SpriteInfo const& sprite = graphics::spriteTable[command.sprite];
+
+            f32 w = sprite.width * command.scale.x;
+            f32 h = sprite.height * command.scale.y;
+            f32 ax = command.position.x, bx = command.position.x + w;
+            f32 ay = command.position.y, by = command.position.y + h;
+
+            Rect rect {
+                .color = sprite.sdf ? modulate(sprite.tint, command.color) : sprite.tint,
+                .blend = command.blend,
+                .cx = (ax + bx) * 0.5f,
+                .cy = (ay + by) * 0.5f,
+                .cos = 1.0f,
+            };
+            if (command.rotation == 0.0f) {
+                rect.x0 = coverage(std::min(ax, bx), framebuffer.width);
+                rect.y0 = coverage(std::min(ay, by), framebuffer.height);
+                rect.x1 = coverage(std::max(ax, bx), framebuffer.width);
+                rect.y1 = coverage(std::max(ay, by), framebuffer.height);
+            } else {
+                rect.rotated = true;
+                rect.hx = __builtin_fabsf(w) * 0.5f;
+                rect.hy = __builtin_fabsf(h) * 0.5f;
+                rect.cos = __builtin_cosf(command.rotation);
+                rect.sin = __builtin_sinf(command.rotation);
+
+                f32 ex = __builtin_fabsf(rect.cos) * rect.hx + __builtin_fabsf(rect.sin) * rect.hy;
+                f32 ey = __builtin_fabsf(rect.sin) * rect.hx + __builtin_fabsf(rect.cos) * rect.hy;
+                rect.x0 = coverage(rect.cx - ex, framebuffer.width);
+                rect.y0 = coverage(rect.cy - ey, framebuffer.height);
+                rect.x1 = coverage(rect.cx + ex, framebuffer.width);
+                rect.y1 = coverage(rect.cy + ey, framebuffer.height);
+            }
+
+            // Glyphs are only drawn sampled, flat they would fill as boxes.
+            if (w != 0.0f && h != 0.0f && texelSource(sprite, &rect)) {
+                mapTexels(sprite, w, h, &rect);
+            } else if (sprite.sdf) {
+                rect.x1 = rect.x0;
+            }
+            software.rects[i] = rect;
+
+            if (rect.x0 == rect.x1 || rect.y0 == rect.y1) continue;
+
+            for (u32 ty = rect.y0 / tileSize; ty <= (rect.y1 - 1) / tileSize; ty++) {
+                for (u32 tx = rect.x0 / tileSize; tx <= (rect.x1 - 1) / tileSize; tx++) {
+                    software.binOffsets[ty * software.tilesX + tx + 1]++;
+                }
+            }
+        }
+
+        for (u32 t = 0; t < tileCount; t++) {
+            software.binOffsets[t + 1] += software.binOffsets[t];
+        }
+
+        reserve(&software.bins, software.binOffsets[tileCount]);
+
+        // Binning, `binOffsets[t]` is used as the write cursor and ends up
+        // at the start of tile t + 1, shifting it back restores the offsets.
+        for (u32 i = 0; i < commands.len; i++) {
+            Rect rect = software.rects[i];
+            if (rect.x0 == rect.x1 || rect.y0 == rect.y1) continue;
+
+            for (u32 ty = rect.y0 / tileSize; ty <= (rect.y1 - 1) / tileSize; ty++) {
+                for (u32 tx = rect.x0 / tileSize; tx <= (rect.x1 - 1) / tileSize; tx++) {
+                    u32 tile = ty * software.tilesX + tx;
+                    software.bins[software.binOffsets[tile]++] = i;
+                }
+            }
+        }
+
+        for (u32 t = tileCount; t > 0; t--) {
+            software.binOffsets[t] = software.binOffsets[t - 1];
+        }
+        software.binOffsets[0] = 0;
+
+        jobs::parallelFor(tileCount, rasterTile, nullptr);
+    }
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <std/slice.h>
+
+#include "core/sprites.h"
+
+// CPU backend for machines without a Vulkan device. The framebuffer is split
+// into tiles, sprites are binned per tile in submission order and tiles are
+// rasterized in parallel, so the output doesn't depend on the thread count.
+// Sprites sample the host copy of their texture (nearest, fixed point),
+// glyphs the host copy of the atlas.
+namespace igfx::software {
+    constexpr u32 tileSize = 64;
+
+    struct Framebuffer {
+        u32 width;
+        u32 height;
+        std::Buf<u32> pixels; // RGBA8, row-major, top-left origin
+    };
+
+    extern Framebuffer framebuffer;
+
+    void init(u32 width, u32 height);
+    void deinit();
+
+    void render(std::Slice<graphics::SpriteCommand> commands);
+}
@@ -0,0 +1,729 @@
+#include "core/spritebatch.h"
+#include "core/textures.h"
+
+#include <std/alloc.h>
+#include <std/array.h>
+#include <std/math.h>
+
+namespace igfx::graphics {
+    SpriteBatch spriteBatch;
+
+    constexpr u32 vertexCode[] =
+#include "quad.vert.inc"
+    ;
+
+    constexpr u32 fragmentCode[] =
+#include "quad.frag.inc"
+    ;
+
+    inline u32 packHalf2(f32 x, f32 y) {
+        u16 lo = __builtin_bit_cast(u16, (_Float16)x);
+        u16 hi = __builtin_bit_cast(u16, (_Float16)y);
+        return lo | ((u32)hi << 16);
+    }
+
+    // Radians to a unorm16 fraction of a turn.
+    inline u32 packRotation(f32 radians) {
+        f32 turns = radians * (1.0f / 6.28318530718f);
+        turns -= __builtin_floorf(turns);
+        return (u32)(turns * 65536.0f) & 0xffff;
+    }
+
+    inline GpuSprite packSprite(SpriteInfo const& sprite) {
+        return {
+            .uvRect = {
+                sprite.uv[0] | ((u32)sprite.uv[1] << 16),
+                sprite.uv[2] | ((u32)sprite.uv[3] << 16),
+            },
+            .tint = sprite.tint,
+            .size = packHalf2((f32)sprite.width, (f32)sprite.height),
+        };
+    }
+
+    VkShaderModule createShaderModule(std::Slice<u32 const> code) {
+        VkShaderModuleCreateInfo createInfo {
+            .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+            .codeSize = code.len * sizeof(u32),
+            .pCode = code.ptr,
+        };
+
+        VkShaderModule module;
+        if (vkCreateShaderModule(
+            graphics.device,
+            &createInfo,
+            nullptr,
+            &module
+        ) != VK_SUCCESS) std::fatal("failed to create shader module");
+
+        return module;
+    }
+
+    VkPipelineColorBlendAttachmentState blendState(BlendMode blend) {
+        VkPipelineColorBlendAttachmentState state {
+            .blendEnable = VK_TRUE,
+            .colorBlendOp = VK_BLEND_OP_ADD,
+            .alphaBlendOp = VK_BLEND_OP_ADD,
+            .colorWriteMask = VK_COLOR_COMPONENT_R_BIT
+                | VK_COLOR_COMPONENT_G_BIT
+                | VK_COLOR_COMPONENT_B_BIT
+                | VK_COLOR_COMPONENT_A_BIT,
+        };
+
+        switch (blend) {
+        case BlendMode::Alpha:
+            state.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+            state.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+            state.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+            state.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+            break;
+        case BlendMode::Additive:
+            state.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+            state.dstColorBlendFactor = VK_BLEND_FACTOR_ONE;
+            state.srcAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+            state.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+            break;
+        case BlendMode::Multiply:
+            // The fragment shader fades the color to white by alpha.
+            state.srcColorBlendFactor = VK_BLEND_FACTOR_DST_COLOR;
+            state.dstColorBlendFactor = VK_BLEND_FACTOR_ZERO;
+            state.srcAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+            state.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+            break;
+        }
+
+        return state;
+    }
+
+    // Runs on a job thread, see PipelineCache.
+    VkPipeline compilePipeline(PipelineKey key, VkPipelineCache cache) {
+        // The shaders' `blendMode` and `sdfText` constants.
+        struct {
+            u32 blendMode;
+            VkBool32 sdfText;
+        } constants {(u32)key.blend, key.sdf};
+
+        auto specializationEntries = std::arr<VkSpecializationMapEntry>(
+            VkSpecializationMapEntry{
+                .constantID = 0,
+                .offset = 0,
+                .size = sizeof(u32),
+            },
+            VkSpecializationMapEntry{
+                .constantID = 1,
+                .offset = sizeof(u32),
+                .size = sizeof(VkBool32),
+            }
+        );
+
+        VkSpecializationInfo specialization {
+            .mapEntryCount = specializationEntries.len(),
+            .pMapEntries = specializationEntries.data,
+            .dataSize = sizeof(constants),
+            .pData = &constants,
+        };
+
+        auto stages = std::arr<VkPipelineShaderStageCreateInfo>(
+            VkPipelineShaderStageCreateInfo{
+                .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+                .stage = VK_SHADER_STAGE_VERTEX_BIT,
+                .module = spriteBatch.vertexModule,
+                .pName = "main",
+                .pSpecializationInfo = &specialization,
+            },
+            VkPipelineShaderStageCreateInfo{
+                .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+                .stage = VK_SHADER_STAGE_FRAGMENT_BIT,
+                .module = spriteBatch.fragmentModule,
+                .pName = "main",
+                .pSpecializationInfo = &specialization,
+            }
+        );
+
+        // Vertex pulling, no vertex input.
+        VkPipelineVertexInputStateCreateInfo vertexInput {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
+        };
+
+        VkPipelineInputAssemblyStateCreateInfo inputAssembly {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
+            .topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
+        };
+
+        VkPipelineViewportStateCreateInfo viewportState {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
+            .viewportCount = 1,
+            .scissorCount = 1,
+        };
+
+        // Negative scales mirror sprites, so nothing is culled.
+        VkPipelineRasterizationStateCreateInfo rasterization {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
+            .polygonMode = VK_POLYGON_MODE_FILL,
+            .cullMode = VK_CULL_MODE_NONE,
+            .frontFace = VK_FRONT_FACE_CLOCKWISE,
+            .lineWidth = 1.0f,
+        };
+
+        VkPipelineMultisampleStateCreateInfo multisample {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
+            .rasterizationSamples = VK_SAMPLE_COUNT_1_BIT,
+        };
+
+        VkPipelineColorBlendAttachmentState blendAttachment = blendState(key.blend);
+
+        VkPipelineColorBlendStateCreateInfo colorBlend {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
+            .attachmentCount = 1,
+            .pAttachments = &blendAttachment,
+        };
+
+        auto dynamicStates = std::arr<VkDynamicState>(
+            VK_DYNAMIC_STATE_VIEWPORT,
+            VK_DYNAMIC_STATE_SCISSOR
+        );
+
+        VkPipelineDynamicStateCreateInfo dynamicState {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
+            .dynamicStateCount = dynamicStates.len(),
+            .pDynamicStates = dynamicStates.data,
+        };
+
+        VkPipelineRenderingCreateInfo renderingInfo {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO,
+            .colorAttachmentCount = 1,
+            .pColorAttachmentFormats = &key.colorFormat,
+        };
+
+        VkGraphicsPipelineCreateInfo pipelineCreateInfo {
+            .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+            .pNext = &renderingInfo,
+            .stageCount = stages.len(),
+            .pStages = stages.data,
+            .pVertexInputState = &vertexInput,
+            .pInputAssemblyState = &inputAssembly,
+            .pViewportState = &viewportState,
+            .pRasterizationState = &rasterization,
+            .pMultisampleState = &multisample,
+            .pColorBlendState = &colorBlend,
+            .pDynamicState = &dynamicState,
+            .layout = spriteBatch.pipelineLayout,
+        };
+
+        VkPipeline pipeline;
+        if (vkCreateGraphicsPipelines(
+            graphics.device,
+            cache,
+            1,
+            &pipelineCreateInfo,
+            nullptr,
+            &pipeline
+        ) != VK_SUCCESS) std::fatal("failed to create sprite pipeline");
+
+        return pipeline;
+    }
+
+    void createDescriptors(SpriteBatch* batch) {
+        auto bufferBindings = std::arr<VkDescriptorSetLayoutBinding>(
+            VkDescriptorSetLayoutBinding{
+                .binding = 0,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .descriptorCount = 1,
+                .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+            },
+            VkDescriptorSetLayoutBinding{
+                .binding = 1,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .descriptorCount = 1,
+                .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+            }
+        );
+
+        VkDescriptorSetLayoutBinding textureBinding {
+            .binding = 0,
+            .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+            .descriptorCount = 1,
+            .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
+        };
+
+        VkDescriptorSetLayoutCreateInfo bufferLayoutInfo {
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+            .bindingCount = bufferBindings.len(),
+            .pBindings = bufferBindings.data,
+        };
+
+        VkDescriptorSetLayoutCreateInfo textureLayoutInfo {
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+            .bindingCount = 1,
+            .pBindings = &textureBinding,
+        };
+
+        if (
+            vkCreateDescriptorSetLayout(graphics.device, &bufferLayoutInfo, nullptr, &batch->bufferSetLayout)
+                != VK_SUCCESS
+            || vkCreateDescriptorSetLayout(graphics.device, &textureLayoutInfo, nullptr, &batch->textureSetLayout)
+                != VK_SUCCESS
+        ) std::fatal("failed to create descriptor set layouts");
+
+        auto poolSizes = std::arr<VkDescriptorPoolSize>(
+            VkDescriptorPoolSize{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2 * framesInFlight},
+            VkDescriptorPoolSize{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1}
+        );
+
+        VkDescriptorPoolCreateInfo poolInfo {
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+            .maxSets = framesInFlight + 1,
+            .poolSizeCount = poolSizes.len(),
+            .pPoolSizes = poolSizes.data,
+        };
+
+        if (vkCreateDescriptorPool(
+            graphics.device,
+            &poolInfo,
+            nullptr,
+            &batch->descriptorPool
+        ) != VK_SUCCESS) std::fatal("failed to create descriptor pool");
+
+        auto setLayouts = std::arr<VkDescriptorSetLayout>(
+            batch->bufferSetLayout,
+            batch->textureSetLayout
+        );
+
+        VkPushConstantRange pushConstantRange {
+            .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+            .offset = 0,
+            .size = sizeof(vec2),
+        };
+
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+            .setLayoutCount = setLayouts.len(),
+            .pSetLayouts = setLayouts.data,
+            .pushConstantRangeCount = 1,
+            .pPushConstantRanges = &pushConstantRange,
+        };
+
+        if (vkCreatePipelineLayout(
+            graphics.device,
+            &pipelineLayoutInfo,
+            nullptr,
+            &batch->pipelineLayout
+        ) != VK_SUCCESS) std::fatal("failed to create pipeline layout");
+    }
+
+    VkDescriptorSet allocateSet(VkDescriptorSetLayout layout) {
+        VkDescriptorSetAllocateInfo allocateInfo {
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+            .descriptorPool = spriteBatch.descriptorPool,
+            .descriptorSetCount = 1,
+            .pSetLayouts = &layout,
+        };
+
+        VkDescriptorSet set;
+        if (vkAllocateDescriptorSets(
+            graphics.device,
+            &allocateInfo,
+            &set
+        ) != VK_SUCCESS) std::fatal("failed to allocate descriptor set");
+
+        return set;
+    }
+
+    void createWhiteTexture(SpriteBatch* batch) {
+        VkImageCreateInfo imageCreateInfo {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+            .imageType = VK_IMAGE_TYPE_2D,
+            .format = VK_FORMAT_R8G8B8A8_UNORM,
+            .extent = {1, 1, 1},
+            .mipLevels = 1,
+            .arrayLayers = 1,
+            .samples = VK_SAMPLE_COUNT_1_BIT,
+            .tiling = VK_IMAGE_TILING_OPTIMAL,
+            .usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+            .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+            .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        };
+
+        if (vkCreateImage(
+            graphics.device,
+            &imageCreateInfo,
+            nullptr,
+            &batch->whiteImage
+        ) != VK_SUCCESS) std::fatal("failed to create image");
+
+        VkMemoryRequirements requirements;
+        vkGetImageMemoryRequirements(graphics.device, batch->whiteImage, &requirements);
+
+        VkMemoryAllocateInfo allocateInfo {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+            .allocationSize = requirements.size,
+            .memoryTypeIndex = findMemoryType(
+                requirements.memoryTypeBits,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+            ),
+        };
+
+        if (vkAllocateMemory(
+            graphics.device,
+            &allocateInfo,
+            nullptr,
+            &batch->whiteMemory
+        ) != VK_SUCCESS) std::fatal("failed to allocate image memory");
+
+        vkBindImageMemory(graphics.device, batch->whiteImage, batch->whiteMemory, 0);
+
+        VkImageSubresourceRange range {
+            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .levelCount = 1,
+            .layerCount = 1,
+        };
+
+        VkImageViewCreateInfo viewCreateInfo {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+            .image = batch->whiteImage,
+            .viewType = VK_IMAGE_VIEW_TYPE_2D,
+            .format = VK_FORMAT_R8G8B8A8_UNORM,
+            .subresourceRange = range,
+        };
+
+        if (vkCreateImageView(
+            graphics.device,
+            &viewCreateInfo,
+            nullptr,
+            &batch->whiteView
+        ) != VK_SUCCESS) std::fatal("failed to create image view");
+
+        Buffer staging = createBuffer(
+            sizeof(u32),
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+        );
+        defer { destroyBuffer(staging); };
+        *(u32*)staging.mapped = 0xffffffff;
+
+        VkCommandBuffer commandBuffer = beginImmediate();
+
+        VkImageMemoryBarrier2 toTransfer {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+            .srcStageMask = VK_PIPELINE_STAGE_2_NONE,
+            .dstStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+            .dstAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+            .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+            .newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image = batch->whiteImage,
+            .subresourceRange = range,
+        };
+
+        VkDependencyInfo toTransferDependency {
+            .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+            .imageMemoryBarrierCount = 1,
+            .pImageMemoryBarriers = &toTransfer,
+        };
+        vkCmdPipelineBarrier2(commandBuffer, &toTransferDependency);
+
+        VkBufferImageCopy region {
+            .imageSubresource = {
+                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .layerCount = 1,
+            },
+            .imageExtent = {1, 1, 1},
+        };
+        vkCmdCopyBufferToImage(
+            commandBuffer,
+            staging.buffer,
+            batch->whiteImage,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            1,
+            &region
+        );
+
+        VkImageMemoryBarrier2 toShader {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+            .srcStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+            .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+            .dstStageMask = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+            .dstAccessMask = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+            .oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            .newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image = batch->whiteImage,
+            .subresourceRange = range,
+        };
+
+        VkDependencyInfo toShaderDependency {
+            .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+            .imageMemoryBarrierCount = 1,
+            .pImageMemoryBarriers = &toShader,
+        };
+        vkCmdPipelineBarrier2(commandBuffer, &toShaderDependency);
+
+        endImmediate(commandBuffer);
+
+        VkSamplerCreateInfo samplerCreateInfo {
+            .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+            .magFilter = VK_FILTER_LINEAR,
+            .minFilter = VK_FILTER_LINEAR,
+            .mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR,
+            .addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+            .addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+            .addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+            .maxLod = VK_LOD_CLAMP_NONE,
+        };
+
+        if (vkCreateSampler(
+            graphics.device,
+            &samplerCreateInfo,
+            nullptr,
+            &batch->sampler
+        ) != VK_SUCCESS) std::fatal("failed to create sampler");
+    }
+
+    void SpriteBatch::init(VkFormat colorFormat) {
+        createDescriptors(this);
+        createWhiteTexture(this);
+
+        vertexModule = createShaderModule(
+            std::Slice(vertexCode, sizeof(vertexCode) / sizeof(u32))
+        );
+        fragmentModule = createShaderModule(
+            std::Slice(fragmentCode, sizeof(fragmentCode) / sizeof(u32))
+        );
+
+        // Every variant compiles in the background from the start, the
+        // first draw waits for the default one only.
+        this->colorFormat = colorFormat;
+        pipelines.init(compilePipeline);
+        for (u32 blend = 0; blend < blendModeCount; blend++) {
+            pipelines.prepare({colorFormat, (BlendMode)blend, false});
+            pipelines.prepare({colorFormat, (BlendMode)blend, true});
+        }
+
+        for (u32 i = 0; i < framesInFlight; i++) {
+            instances[i] = createBuffer(
+                SpriteList::capacity * sizeof(SpriteInstance),
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+            );
+            sprites[i] = createBuffer(
+                SpriteTable::capacity * sizeof(GpuSprite),
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+            );
+            counts[i] = 0;
+            batches[i] = std::alloc<DrawBatch>(SpriteList::capacity);
+            batchCounts[i] = 0;
+            spritesStale[i] = true;
+
+            bufferSets[i] = allocateSet(bufferSetLayout);
+
+            auto bufferInfos = std::arr<VkDescriptorBufferInfo>(
+                VkDescriptorBufferInfo{instances[i].buffer, 0, VK_WHOLE_SIZE},
+                VkDescriptorBufferInfo{sprites[i].buffer, 0, VK_WHOLE_SIZE}
+            );
+
+            VkWriteDescriptorSet write {
+                .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet = bufferSets[i],
+                .dstBinding = 0,
+                .descriptorCount = bufferInfos.len(),
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .pBufferInfo = bufferInfos.data,
+            };
+            vkUpdateDescriptorSets(graphics.device, 1, &write, 0, nullptr);
+        }
+
+        whiteSet = allocateSet(textureSetLayout);
+
+        VkDescriptorImageInfo imageInfo {
+            .sampler = sampler,
+            .imageView = whiteView,
+            .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        };
+
+        VkWriteDescriptorSet write {
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet = whiteSet,
+            .dstBinding = 0,
+            .descriptorCount = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+            .pImageInfo = &imageInfo,
+        };
+        vkUpdateDescriptorSets(graphics.device, 1, &write, 0, nullptr);
+
+        std::debug(
+            "sprite batch: {} B instances, {} KiB per frame at capacity",
+            sizeof(SpriteInstance),
+            SpriteList::capacity * sizeof(SpriteInstance) / 1024
+        );
+    }
+
+    void SpriteBatch::deinit() {
+        for (u32 i = 0; i < framesInFlight; i++) {
+            destroyBuffer(instances[i]);
+            destroyBuffer(sprites[i]);
+            std::free(batches[i]);
+        }
+
+        vkDestroySampler(graphics.device, sampler, nullptr);
+        vkDestroyImageView(graphics.device, whiteView, nullptr);
+        vkDestroyImage(graphics.device, whiteImage, nullptr);
+        vkFreeMemory(graphics.device, whiteMemory, nullptr);
+
+        pipelines.deinit();
+        vkDestroyShaderModule(graphics.device, vertexModule, nullptr);
+        vkDestroyShaderModule(graphics.device, fragmentModule, nullptr);
+        vkDestroyPipelineLayout(graphics.device, pipelineLayout, nullptr);
+        vkDestroyDescriptorPool(graphics.device, descriptorPool, nullptr);
+        vkDestroyDescriptorSetLayout(graphics.device, bufferSetLayout, nullptr);
+        vkDestroyDescriptorSetLayout(graphics.device, textureSetLayout, nullptr);
+    }
+
+    void SpriteBatch::upload(u32 frameIndex, std::Slice<SpriteCommand> commands) {
+        if (spriteTable.dirty) {
+            for (bool& stale : spritesStale) stale = true;
+            spriteTable.dirty = false;
+        }
+
+        if (spritesStale[frameIndex]) {
+            GpuSprite* dst = (GpuSprite*)sprites[frameIndex].mapped;
+            for (u32 i = 0; i < spriteTable.count; i++) dst[i] = packSprite(spriteTable.entries[i]);
+            spritesStale[frameIndex] = false;
+        }
+
+        SpriteInstance* dst = (SpriteInstance*)instances[frameIndex].mapped;
+        DrawBatch* frameBatches = batches[frameIndex].ptr;
+        u32 batchCount = 0;
+
+        for (u32 i = 0; i < commands.len; i++) {
+            SpriteCommand command = commands[i];
+            u32 sprite = command.sprite < spriteTable.count ? command.sprite : 0;
+
+            SpriteInfo const& info = spriteTable.entries[sprite];
+            BlendMode blend = command.blend;
+            if (
+                batchCount == 0
+                || frameBatches[batchCount - 1].texture != info.texture
+                || frameBatches[batchCount - 1].blend != blend
+                || frameBatches[batchCount - 1].sdf != info.sdf
+            ) {
+                touchTexture(info.texture);
+                frameBatches[batchCount++] = {i, 0, info.texture, blend, info.sdf};
+            }
+            frameBatches[batchCount - 1].count++;
+
+            // Glyphs are never rotated or stretched, the spare half of the
+            // scale and the rotation carry the string's color instead.
+            if (info.sdf) {
+                dst[i] = {
+                    .x = command.position.x,
+                    .y = command.position.y,
+                    .scale = (packHalf2(command.scale.x, 0.0f) & 0xffff) | (command.color << 16),
+                    .rotationSprite = (command.color >> 16) | (sprite << 16),
+                };
+                continue;
+            }
+
+            dst[i] = {
+                .x = command.position.x,
+                .y = command.position.y,
+                .scale = packHalf2(command.scale.x, command.scale.y),
+                .rotationSprite = packRotation(command.rotation) | (sprite << 16),
+            };
+        }
+
+        counts[frameIndex] = commands.len;
+        batchCounts[frameIndex] = batchCount;
+    }
+
+    void SpriteBatch::draw(PassContext* context, u32 frameIndex, SpriteLayer layer) {
+        if (counts[frameIndex] == 0) return;
+
+        VkCommandBuffer commandBuffer = context->commandBuffer;
+
+        VkViewport viewport {
+            .width = (f32)context->extent.width,
+            .height = (f32)context->extent.height,
+            .maxDepth = 1.0f,
+        };
+        vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+
+        VkRect2D scissor {.extent = context->extent};
+        vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+        vkCmdBindDescriptorSets(
+            commandBuffer,
+            VK_PIPELINE_BIND_POINT_GRAPHICS,
+            pipelineLayout,
+            0,
+            1,
+            &bufferSets[frameIndex],
+            0,
+            nullptr
+        );
+
+        // Sprite positions are in window pixels whatever the resolution
+        // drawn at, the viewport scales them.
+        vec2 size = {(f32)graphics.swapchainExtent.width, (f32)graphics.swapchainExtent.height};
+        vkCmdPushConstants(
+            commandBuffer,
+            pipelineLayout,
+            VK_SHADER_STAGE_VERTEX_BIT,
+            0,
+            sizeof(size),
+            &size
+        );
+
+        VkPipeline boundPipeline = nullptr;
+        VkDescriptorSet bound = nullptr;
+        for (u32 i = 0; i < batchCounts[frameIndex]; i++) {
+            DrawBatch batch = batches[frameIndex][i];
+            if (layer == SpriteLayer::Scene && batch.sdf) continue;
+            if (layer == SpriteLayer::Text && !batch.sdf) continue;
+
+            // Prepared at init. Only the default blend mode is waited for,
+            // another one draws alpha blended until its compilation
+            // finishes rather than stalling the pass.
+            VkPipeline pipeline = pipelines.find({colorFormat, batch.blend, batch.sdf});
+            if (pipeline == nullptr) {
+                pipeline = pipelines.wait({colorFormat, BlendMode::Alpha, batch.sdf});
+            }
+            if (pipeline != boundPipeline) {
+                vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+                boundPipeline = pipeline;
+            }
+
+            VkDescriptorSet set = textureSet(batch.texture);
+            if (set == nullptr) set = whiteSet;
+
+            if (set != bound) {
+                vkCmdBindDescriptorSets(
+                    commandBuffer,
+                    VK_PIPELINE_BIND_POINT_GRAPHICS,
+                    pipelineLayout,
+                    1,
+                    1,
+                    &set,
+                    0,
+                    nullptr
+                );
+                bound = set;
+            }
+
+            vkCmdDraw(commandBuffer, 6, batch.count, 0, batch.first);
+        }
+    }
+
+    void spritePass(PassContext* context, void*) {
+        spriteBatch.draw(context, graphics.frameIndex, SpriteLayer::All);
+    }
+
+    void scenePass(PassContext* context, void*) {
+        spriteBatch.draw(context, graphics.frameIndex, SpriteLayer::Scene);
+    }
+
+    void textPass(PassContext* context, void*) {
+        spriteBatch.draw(context, graphics.frameIndex, SpriteLayer::Text);
+    }
+}
@@ -0,0 +1,105 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <std/slice.h>
+
+#include "core/graphics.h"
+#include "core/sprites.h"
+#include "core/pipelines.h"
+
+// Sprites are drawn as instances pulled from storage buffers by
+// gl_VertexIndex/gl_InstanceIndex (shaders/quad.vert), no vertex buffers.
+// Everything an instance shares with others drawing the same sprite (UV
+// rect, tint, texture, pixel size) lives in the sprite table, the instance
+// keeps what changes per draw packed into 16 bytes.
+//
+// Upload per sprite, and per frame at SpriteList::capacity (65536):
+//
+//   layout                                        per sprite   per frame
+//   fat vertices, 4 x (pos, uv, rgba f32) + 6 idx    140 B      9.2 MB
+//   unpacked instance (std430 padded to vec4)         64 B      4.2 MB
+//   packed instance (this)                            16 B      1.0 MB
+//
+// At 60 fps that is 550 MB/s vs 252 MB/s vs 63 MB/s of host to device
+// traffic, and the vertex shader reads each instance from cache six times.
+namespace igfx::graphics {
+    // Text glyphs (SpriteInfo::sdf) are drawn unrotated at a uniform
+    // scale, their instance keeps the string's RGBA8 color in the unused
+    // bits: scale = f16 | RG << 16, rotationSprite = BA | sprite << 16.
+    struct SpriteInstance {
+        f32 x, y;
+        u32 scale;          // f16x2
+        u32 rotationSprite; // unorm16 fraction of a turn | sprite index << 16
+    };
+
+    static_assert(sizeof(SpriteInstance) == 16);
+
+    // GPU copy of a `SpriteInfo`.
+    struct GpuSprite {
+        u32 uvRect[2]; // unorm16x4 (u0, v0, u1, v1)
+        u32 tint;      // RGBA8
+        u32 size;      // f16x2 pixels
+    };
+
+    static_assert(sizeof(GpuSprite) == 16);
+
+    // Consecutive instances drawn with the same texture and pipeline.
+    struct DrawBatch {
+        u32 first;
+        u32 count;
+        u32 texture;
+        BlendMode blend;
+        bool sdf;
+    };
+
+    // Which batches a pass draws, with dynamic resolution sprites and text
+    // are drawn by separate passes at different resolutions.
+    enum class SpriteLayer : u8 {
+        All,
+        Scene, // everything but text
+        Text,
+    };
+
+    struct SpriteBatch {
+        VkDescriptorSetLayout bufferSetLayout;  // set 0, instances + sprites
+        VkDescriptorSetLayout textureSetLayout; // set 1, sampled texture
+        VkDescriptorPool descriptorPool;
+        VkPipelineLayout pipelineLayout;
+
+        // Pipelines by blend mode and text, sharing the shader modules.
+        VkShaderModule vertexModule;
+        VkShaderModule fragmentModule;
+        VkFormat colorFormat;
+        PipelineCache pipelines;
+
+        // Host visible, written while the frame's fence guards them.
+        Buffer instances[framesInFlight];
+        Buffer sprites[framesInFlight];
+        VkDescriptorSet bufferSets[framesInFlight];
+        u32 counts[framesInFlight];
+        std::Buf<DrawBatch> batches[framesInFlight];
+        u32 batchCounts[framesInFlight];
+        bool spritesStale[framesInFlight];
+
+        // The default sprite's 1x1 white texture, also drawn in place of
+        // textures that are not resident.
+        VkImage whiteImage;
+        VkDeviceMemory whiteMemory;
+        VkImageView whiteView;
+        VkSampler sampler;
+        VkDescriptorSet whiteSet;
+
+        void init(VkFormat colorFormat);
+        void deinit();
+
+        // Packs the frame's sprites into its instance buffer, grouped by
+        // texture, and stamps the textures used for residency.
+        void upload(u32 frameIndex, std::Slice<SpriteCommand> commands);
+        void draw(PassContext* context, u32 frameIndex, SpriteLayer layer);
+    };
+
+    extern SpriteBatch spriteBatch;
+
+    void spritePass(PassContext* context, void* userData);
+    void scenePass(PassContext* context, void* userData);
+    void textPass(PassContext* context, void* userData);
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <std/slice.h>
+
+#include "igfx/graphics.h"
+
+namespace igfx::graphics {
+    // A `Frame::DrawSprite` call as recorded for the backends.
+    struct SpriteCommand {
+        u32 sprite;
+        vec2 position;
+        vec2 scale;
+        f32 rotation;
+        BlendMode blend;
+        u32 color; // RGBA8 (0xAABBGGRR), text glyphs only (see spritebatch.h)
+    };
+
+    // What a `Sprite` index refers to, shared by every instance drawing it
+    // so per instance data stays small (see spritebatch.h).
+    struct SpriteInfo {
+        u32 width;  // pixels at scale 1
+        u32 height;
+        u16 uv[4];  // unorm16 u0, v0, u1, v1
+        u32 tint;   // RGBA8, R in the low byte (0xAABBGGRR)
+        u32 texture;
+        bool sdf;   // a glyph atlas cell, see text.h
+    };
+
+    struct SpriteTable {
+        static constexpr u32 capacity = 4096;
+
+        SpriteInfo entries[capacity];
+        u32 count;
+        bool dirty; // entries changed since the GPU copy was uploaded
+
+        // Unknown indices draw as the default sprite.
+        SpriteInfo const& operator[](u32 sprite) const {
+            return entries[sprite < count ? sprite : 0];
+        }
+    };
+
+    // Entry 0 is the default sprite, a 1x1 white texel.
+    extern SpriteTable spriteTable;
+
+    struct SpriteList {
+        static constexpr u32 capacity = 1 << 16;
+
+        SpriteCommand commands[capacity];
+        u32 count;
+
+        void push(SpriteCommand command) {
+            if (count == capacity) {
+                std::warn("sprite limit ({}) reached, dropping sprite", capacity);
+                return;
+            }
+
+            commands[count++] = command;
+        }
+
+        std::Slice<SpriteCommand> slice() {
+            return std::Slice(commands, count);
+        }
+
+        void clear() {
+            count = 0;
+        }
+    };
+
+    // One list per frame slot, `Frame::index` picks the list being recorded
+    // (see engine::beginFrame).
+    constexpr u32 maxFrameSlots = 3;
+    extern SpriteList spriteLists[maxFrameSlots];
+}
@@ -0,0 +1,81 @@
+#include "core/startup.h"
+#include "core/timer.h"
+
+namespace igfx::startup {
+    Startup startup;
+
+    void begin() {
+        startup = {.start = timer::now()};
+    }
+
+    u32 phase(u8 const* name) {
+        // Work after the first frame (e.g. a pipeline compiled on demand)
+        // is not startup.
+        if (__atomic_load_n(&startup.finished, __ATOMIC_RELAXED)) return StartupReport::maxPhases;
+
+        u32 index = __atomic_fetch_add(&startup.count, 1, __ATOMIC_RELAXED);
+        if (index >= StartupReport::maxPhases) return index;
+
+        Startup::Entry& entry = startup.entries[index];
+        entry.phase = {
+            .name = name,
+            .start = (f32)(timer::now() - startup.start),
+        };
+        __atomic_store_n(&entry.state, Startup::Running, __ATOMIC_RELEASE);
+        return index;
+    }
+
+    void end(u32 phase) {
+        if (phase >= StartupReport::maxPhases) return;
+
+        Startup::Entry& entry = startup.entries[phase];
+        entry.phase.duration = (f32)(timer::now() - startup.start) - entry.phase.start;
+        __atomic_store_n(&entry.state, Startup::Done, __ATOMIC_RELEASE);
+    }
+
+    void finish() {
+        if (startup.finished) return;
+        __atomic_store_n(&startup.finished, true, __ATOMIC_RELAXED);
+
+        u32 count = __atomic_load_n(&startup.count, __ATOMIC_ACQUIRE);
+        if (count > StartupReport::maxPhases) {
+            std::warn("startup: {} phases not recorded", count - StartupReport::maxPhases);
+            count = StartupReport::maxPhases;
+        }
+
+        StartupReport& report = startup.report;
+        report.phaseCount = 0;
+        report.total = (f32)(timer::now() - startup.start);
+
+        // Phases still running on job threads are reported without a
+        // duration, one whose entry isn't written yet began after now.
+        for (u32 i = 0; i < count; i++) {
+            Startup::Entry const& entry = startup.entries[i];
+            u32 state = __atomic_load_n(&entry.state, __ATOMIC_ACQUIRE);
+            if (state == Startup::Reserved) continue;
+
+            // The duration may still be written while running.
+            report.phases[report.phaseCount++] = {
+                .name = entry.phase.name,
+                .start = entry.phase.start,
+                .duration = state == Startup::Done ? entry.phase.duration : -1.0f,
+            };
+        }
+
+        std::debug("startup: first frame after {} ms", report.total * 1000.0f);
+        for (u32 i = 0; i < report.phaseCount; i++) {
+            StartupPhase const& phase = report.phases[i];
+            if (phase.duration < 0.0f) {
+                std::debug("  {} at {} ms, still running", phase.name, phase.start * 1000.0f);
+                continue;
+            }
+
+            std::debug(
+                "  {} at {} ms, took {} ms",
+                phase.name,
+                phase.start * 1000.0f,
+                phase.duration * 1000.0f
+            );
+        }
+    }
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include "igfx/graphics.h"
+
+// Timed phases of engine startup, from `engine::init` to the first
+// rendered frame. Phases may run concurrently on job threads, the report
+// lists each with its start offset so overlap shows.
+namespace igfx::startup {
+    struct Startup {
+        // u32 for the atomic builtins.
+        enum State : u32 {
+            Reserved,
+            Running, // name and start are published
+            Done, // duration is published
+        };
+
+        // Written by the thread running the phase, released through
+        // `state` and copied into the report by `finish`.
+        struct Entry {
+            StartupPhase phase;
+            u32 state;
+        };
+
+        f64 start;
+        u32 count; // phases begun, atomic
+        bool finished;
+        Entry entries[StartupReport::maxPhases];
+        StartupReport report;
+    };
+
+    extern Startup startup;
+
+    void begin();
+
+    // Thread safe. Returns the phase to pass to `end`.
+    u32 phase(u8 const* name);
+    void end(u32 phase);
+
+    // Closes the report at the first rendered frame and logs it.
+    void finish();
+}
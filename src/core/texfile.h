@@ -0,0 +1,81 @@
+#pragma once
+#include <std/math.h>
+
+// Baked texture (.igtex) as written by `bake`, a `Header` followed by the
+// full mip chain, mip 0 first, each level directly after the previous.
+namespace igfx::texfile {
+    constexpr u32 version = 1;
+    constexpr u8 magic[8] = {'i', 'g', 'f', 'x', 't', 'e', 'x', '\0'};
+
+    enum class Format : u32 {
+        RGBA8,
+        BC3, // 4x4 blocks of 16 bytes, interpolated alpha
+        BC7, // 4x4 blocks of 16 bytes, mode 6 only
+    };
+
+    constexpr u32 formatCount = 3;
+
+    struct Header {
+        u8 magic[8];
+        u32 version;
+        Format format;
+        u32 width;
+        u32 height;
+        u32 mipCount;
+    };
+
+    constexpr u32 maxMips = 16;
+
+    inline bool compressed(Format format) {
+        return format != Format::RGBA8;
+    }
+
+    inline u32 mipCount(u32 width, u32 height) {
+        u32 count = 1;
+        while ((width > 1 || height > 1) && count < maxMips) {
+            width = std::max(width / 2, 1u);
+            height = std::max(height / 2, 1u);
+            count++;
+        }
+
+        return count;
+    }
+
+    inline usize levelSize(Format format, u32 width, u32 height) {
+        if (!compressed(format)) return (usize)width * height * 4;
+        return (usize)((width + 3) / 4) * ((height + 3) / 4) * 16;
+    }
+
+    // 2x2 box filter over RGBA8, odd edges repeat their last texel. `dst`
+    // may alias `src`, every texel is read before it is overwritten.
+    inline void downsample(u32 const* src, u32 srcWidth, u32 srcHeight, u32* dst) {
+        u32 width = std::max(srcWidth / 2, 1u);
+        u32 height = std::max(srcHeight / 2, 1u);
+
+        for (u32 y = 0; y < height; y++) {
+            u32 y0 = std::min(y * 2, srcHeight - 1);
+            u32 y1 = std::min(y * 2 + 1, srcHeight - 1);
+
+            for (u32 x = 0; x < width; x++) {
+                u32 x0 = std::min(x * 2, srcWidth - 1);
+                u32 x1 = std::min(x * 2 + 1, srcWidth - 1);
+
+                u32 texels[4] = {
+                    src[y0 * srcWidth + x0],
+                    src[y0 * srcWidth + x1],
+                    src[y1 * srcWidth + x0],
+                    src[y1 * srcWidth + x1],
+                };
+
+                u32 result = 0;
+                for (u32 shift = 0; shift < 32; shift += 8) {
+                    u32 sum = 2;
+                    for (u32 texel : texels) sum += (texel >> shift) & 0xff;
+                    result |= (sum / 4) << shift;
+                }
+
+                dst[y * width + x] = result;
+            }
+        }
+    }
+}
@@ -0,0 +1,682 @@
+#include "core/text.h"
+#include "core/textures.h"
+#include "core/jobs.h"
+
+#include <std/alloc.h>
+#include <std/math.h>
+
+namespace igfx::graphics {
+    Text text;
+
+    constexpr u32 cellBytes = Text::cellSize * Text::cellSize;
+
+    inline u16 atlasUnorm(u32 pixel) {
+        return (u16)(pixel * 65535u / Text::atlasSize);
+    }
+
+    void initText() {
+        text.fontCount = 0;
+        text.frame = 0;
+        text.dirtyCount = 0;
+        text.warnedFull = false;
+        text.mutex.init();
+    }
+
+    void freeLayout(Layout* layout) {
+        std::free(layout->text);
+        std::free(layout->glyphs);
+        layout->font = 0;
+    }
+
+    void deinitText() {
+        for (u32 i = 1; i <= text.fontCount; i++) {
+            truetype::unload(&text.fonts[i].font);
+            std::free(text.fonts[i].cells);
+        }
+
+        for (Layout& layout : text.layouts) {
+            if (layout.font != 0) freeLayout(&layout);
+        }
+
+        if (text.pixels.len > 0) std::free(text.pixels);
+        text.mutex.deinit();
+    }
+
+    // The atlas texture and one sprite per cell, reserved with the first
+    // font.
+    void reserveCells() {
+        text.pixels = std::alloc<u8>(Text::atlasSize * Text::atlasSize);
+        __builtin_memset(text.pixels.ptr, 0, text.pixels.len);
+
+        text.texture = addExternalTexture(text.set);
+
+        SpriteTable& table = spriteTable;
+        if (table.count + Text::cellCount > SpriteTable::capacity) {
+            std::fatal("sprite limit ({}) reached reserving glyph cells", SpriteTable::capacity);
+        }
+
+        text.firstSprite = table.count;
+        for (u32 i = 0; i < Text::cellCount; i++) {
+            u32 x = (i % Text::cellsPerRow) * Text::cellSize;
+            u32 y = (i / Text::cellsPerRow) * Text::cellSize;
+
+            table.entries[table.count++] = {
+                .width = Text::cellSize,
+                .height = Text::cellSize,
+                .uv = {
+                    atlasUnorm(x),
+                    atlasUnorm(y),
+                    atlasUnorm(x + Text::cellSize),
+                    atlasUnorm(y + Text::cellSize),
+                },
+                .tint = 0xffffffff,
+                .texture = text.texture,
+                .sdf = true,
+            };
+
+            text.cells[i] = {};
+            text.pending[i] = false;
+        }
+        table.dirty = true;
+    }
+
+    u32 loadFont(u8 const* path) {
+        if (text.fontCount == Text::maxFonts) {
+            std::warn("font limit ({}) reached, '{}' not loaded", Text::maxFonts, path);
+            return 0;
+        }
+
+        FontEntry entry {};
+        if (!truetype::load(&entry.font, path)) return 0;
+        if (text.fontCount == 0) reserveCells();
+
+        entry.cells = std::alloc<u16>(std::max(entry.font.glyphCount, 1u));
+        for (u32 i = 0; i < entry.cells.len; i++) entry.cells[i] = Text::noCell;
+
+        f32 em = (f32)entry.font.unitsPerEm;
+        entry.ascent = entry.font.ascent / em;
+        entry.lineHeight = (entry.font.ascent - entry.font.descent + entry.font.lineGap) / em;
+
+        text.fonts[++text.fontCount] = entry;
+        std::debug("text: loaded '{}' ({} glyphs)", path, entry.font.glyphCount);
+        return text.fontCount;
+    }
+
+    void beginTextFrame() {
+        text.frame++;
+    }
+
+    // Next codepoint at `*i`, U+FFFD for malformed sequences. Stops at the
+    // terminator, continuation bytes are never read past it.
+    u32 decode(u8 const* string, usize* i) {
+        u32 lead = (unsigned char)string[(*i)++];
+        if (lead < 0x80) return lead;
+
+        u32 extra = lead >= 0xf0 ? 3 : lead >= 0xe0 ? 2 : lead >= 0xc0 ? 1 : 0;
+        if (extra == 0 || lead >= 0xf8) return 0xfffd;
+
+        u32 codepoint = lead & (0x3f >> extra);
+        for (u32 k = 0; k < extra; k++) {
+            u32 next = (unsigned char)string[*i];
+            if ((next & 0xc0) != 0x80) return 0xfffd;
+
+            codepoint = (codepoint << 6) | (next & 0x3f);
+            (*i)++;
+        }
+
+        return codepoint;
+    }
+
+    void layoutText(Layout* layout, FontEntry const& entry, u8 const* string, usize length) {
+        layout->text = std::alloc<u8>(length);
+        __builtin_memcpy(layout->text.ptr, string, length);
+
+        // At most a glyph per byte.
+        layout->glyphs = std::alloc<LaidGlyph>(length);
+        layout->glyphCount = 0;
+
+        f32 em = (f32)entry.font.unitsPerEm;
+        f32 x = 0.0f, y = 0.0f, width = 0.0f;
+        for (usize i = 0; i < length;) {
+            u32 codepoint = decode(string, &i);
+            if (codepoint == '\n') {
+                width = std::max(width, x);
+                x = 0.0f;
+                y += entry.lineHeight;
+                continue;
+            }
+
+            u32 glyph = truetype::glyphIndex(entry.font, codepoint);
+
+            truetype::GlyphBox box;
+            if (truetype::box(entry.font, glyph, &box)) {
+                layout->glyphs[layout->glyphCount++] = {glyph, x, y};
+            }
+
+            x += truetype::advance(entry.font, glyph) / em;
+        }
+
+        layout->size = {std::max(width, x), y + entry.lineHeight};
+    }
+
+    // FNV-1a.
+    inline u64 hashText(u8 const* string, usize length, u32 font) {
+        u64 hash = 0xcbf29ce484222325ull ^ font;
+        for (usize i = 0; i < length; i++) {
+            hash ^= (unsigned char)string[i];
+            hash *= 0x100000001b3ull;
+        }
+
+        return hash;
+    }
+
+    Layout& findLayout(u32 font, u8 const* string) {
+        usize length = __builtin_strlen(string);
+        u64 hash = hashText(string, length, font);
+
+        Layout* set = &text.layouts[(hash % Text::layoutSets) * Text::layoutWays];
+        Layout* victim = &set[0];
+        for (u32 way = 0; way < Text::layoutWays; way++) {
+            Layout& layout = set[way];
+            if (
+                layout.font == font
+                && layout.hash == hash
+                && layout.text.len == length
+                && __builtin_memcmp(layout.text.ptr, string, length) == 0
+            ) {
+                layout.lastUsed = text.frame;
+                return layout;
+            }
+
+            if (victim->font != 0 && (layout.font == 0 || layout.lastUsed < victim->lastUsed)) {
+                victim = &layout;
+            }
+        }
+
+        if (victim->font != 0) freeLayout(victim);
+
+        layoutText(victim, text.fonts[font], string, length);
+        victim->hash = hash;
+        victim->font = font;
+        victim->lastUsed = text.frame;
+        return *victim;
+    }
+
+    // A free cell, or the least recently drawn one no frame still waiting
+    // to be rendered draws. noCell when every cell is in use.
+    u32 takeCell() {
+        u32 best = Text::noCell;
+        for (u32 i = 0; i < Text::cellCount; i++) {
+            GlyphCell const& cell = text.cells[i];
+            if (cell.font == 0) return i;
+            if (cell.lastUsed + maxFrameSlots > text.frame) continue;
+
+            if (best == Text::noCell || cell.lastUsed < text.cells[best].lastUsed) best = i;
+        }
+
+        if (best != Text::noCell) {
+            GlyphCell& cell = text.cells[best];
+            text.fonts[cell.font].cells[cell.glyph] = Text::noCell;
+            cell.font = 0;
+        }
+
+        return best;
+    }
+
+    struct Rasterize {
+        u32 font;
+        u32 glyph;
+        u32 cell;
+        f32 originX;
+        f32 originY;
+        u8 pixels[cellBytes];
+    };
+
+    // Signed distance to the outline at every cell pixel center, 0.5 on
+    // the edge and `spread` pixels to either end of [0, 1]. Inside is by
+    // the nonzero winding rule.
+    void rasterizeJob(u32 index, void* userData) {
+        Rasterize& job = ((Rasterize*)userData)[index];
+        truetype::Font const& font = text.fonts[job.font].font;
+
+        truetype::GlyphBox box;
+        truetype::box(font, job.glyph, &box);
+
+        f32 scale = Text::emSize / font.unitsPerEm;
+        job.originX = Text::spread - box.xMin * scale;
+        job.originY = Text::spread + box.yMax * scale;
+
+        constexpr u32 maxSegments = 2048;
+        truetype::Segment segments[maxSegments];
+        u32 count = truetype::outline(font, job.glyph, std::Slice(segments, maxSegments));
+
+        // To cell pixels, y down.
+        for (u32 s = 0; s < count; s++) {
+            truetype::Segment& segment = segments[s];
+            segment.x0 = job.originX + segment.x0 * scale;
+            segment.y0 = job.originY - segment.y0 * scale;
+            segment.x1 = job.originX + segment.x1 * scale;
+            segment.y1 = job.originY - segment.y1 * scale;
+        }
+
+        for (u32 py = 0; py < Text::cellSize; py++) {
+            for (u32 px = 0; px < Text::cellSize; px++) {
+                f32 x = px + 0.5f, y = py + 0.5f;
+                f32 nearest = 1e30f;
+                i32 winding = 0;
+
+                for (u32 s = 0; s < count; s++) {
+                    truetype::Segment const& segment = segments[s];
+                    f32 dx = segment.x1 - segment.x0;
+                    f32 dy = segment.y1 - segment.y0;
+                    f32 lengthSquared = dx * dx + dy * dy;
+
+                    f32 t = lengthSquared > 0.0f
+                        ? std::clamp(((x - segment.x0) * dx + (y - segment.y0) * dy) / lengthSquared, 0.0f, 1.0f)
+                        : 0.0f;
+                    f32 ex = segment.x0 + t * dx - x;
+                    f32 ey = segment.y0 + t * dy - y;
+                    nearest = std::min(nearest, ex * ex + ey * ey);
+
+                    if ((segment.y0 <= y) != (segment.y1 <= y)) {
+                        f32 crossing = segment.x0 + (y - segment.y0) / dy * dx;
+                        if (crossing > x) winding += dy > 0.0f ? 1 : -1;
+                    }
+                }
+
+                f32 distance = __builtin_sqrtf(nearest);
+                if (winding == 0) distance = -distance;
+
+                f32 value = std::clamp(0.5f + distance / (2.0f * Text::spread), 0.0f, 1.0f);
+                job.pixels[py * Text::cellSize + px] = (u8)(u32)(value * 255.0f + 0.5f);
+            }
+        }
+    }
+
+    // Gives every glyph of `layout` missing from the atlas a cell, the new
+    // ones are rasterized together on the job threads.
+    void cacheGlyphs(u32 font, Layout const& layout) {
+        FontEntry& entry = text.fonts[font];
+
+        // Cached glyphs are stamped first so `takeCell` can't evict them
+        // to make room for the rest of the same layout.
+        u32 missing = 0;
+        for (u32 i = 0; i < layout.glyphCount; i++) {
+            u32 cell = entry.cells[layout.glyphs[i].glyph];
+            if (cell == Text::noCell) {
+                missing++;
+            } else {
+                text.cells[cell].lastUsed = text.frame;
+            }
+        }
+        if (missing == 0) return;
+
+        auto batch = std::alloc<Rasterize>(missing);
+        defer { std::free(batch); };
+
+        u32 count = 0;
+        for (u32 i = 0; i < layout.glyphCount; i++) {
+            u32 glyph = layout.glyphs[i].glyph;
+            if (entry.cells[glyph] != Text::noCell) continue;
+
+            u32 cell = takeCell();
+            if (cell == Text::noCell) {
+                if (!text.warnedFull) {
+                    std::warn("glyph atlas full ({} cells), glyphs dropped", Text::cellCount);
+                    text.warnedFull = true;
+                }
+                break;
+            }
+
+            entry.cells[glyph] = cell;
+            text.cells[cell] = {.font = font, .glyph = glyph, .lastUsed = text.frame};
+            batch[count++] = {.font = font, .glyph = glyph, .cell = cell};
+        }
+
+        jobs::parallelFor(count, rasterizeJob, batch.ptr);
+
+        text.mutex.lock();
+        for (u32 i = 0; i < count; i++) {
+            Rasterize const& job = batch[i];
+            text.cells[job.cell].originX = job.originX;
+            text.cells[job.cell].originY = job.originY;
+
+            u32 x0 = (job.cell % Text::cellsPerRow) * Text::cellSize;
+            u32 y0 = (job.cell / Text::cellsPerRow) * Text::cellSize;
+            for (u32 row = 0; row < Text::cellSize; row++) {
+                __builtin_memcpy(
+                    &text.pixels[(y0 + row) * Text::atlasSize + x0],
+                    &job.pixels[row * Text::cellSize],
+                    Text::cellSize
+                );
+            }
+
+            if (!text.pending[job.cell]) {
+                text.pending[job.cell] = true;
+                text.dirty[text.dirtyCount++] = job.cell;
+            }
+        }
+        text.mutex.unlock();
+    }
+
+    void drawText(SpriteList* list, u32 font, u8 const* string, DrawTextOptions options) {
+        if (font == 0 || font > text.fontCount || string[0] == '\0') return;
+
+        FontEntry const& entry = text.fonts[font];
+        Layout const& layout = findLayout(font, string);
+        cacheGlyphs(font, layout);
+
+        f32 scale = options.size / Text::emSize;
+        for (u32 i = 0; i < layout.glyphCount; i++) {
+            LaidGlyph glyph = layout.glyphs[i];
+            u32 cell = entry.cells[glyph.glyph];
+            if (cell == Text::noCell) continue;
+
+            GlyphCell& cached = text.cells[cell];
+            cached.lastUsed = text.frame;
+
+            list->push({
+                .sprite = text.firstSprite + cell,
+                .position = {
+                    options.position.x + glyph.x * options.size - cached.originX * scale,
+                    options.position.y + (entry.ascent + glyph.y) * options.size - cached.originY * scale,
+                },
+                .scale = {scale, scale},
+                .rotation = 0.0f,
+                .blend = BlendMode::Alpha,
+                .color = options.color,
+            });
+        }
+    }
+
+    vec2 measureText(u32 font, u8 const* string, f32 size) {
+        if (font == 0 || font > text.fontCount || string[0] == '\0') return {0.0f, 0.0f};
+
+        Layout const& layout = findLayout(font, string);
+        return {layout.size.x * size, layout.size.y * size};
+    }
+
+    void initTextAtlas(VkDescriptorSetLayout setLayout, VkSampler sampler) {
+        VkImageCreateInfo imageCreateInfo {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+            .imageType = VK_IMAGE_TYPE_2D,
+            .format = VK_FORMAT_R8_UNORM,
+            .extent = {Text::atlasSize, Text::atlasSize, 1},
+            .mipLevels = 1,
+            .arrayLayers = 1,
+            .samples = VK_SAMPLE_COUNT_1_BIT,
+            .tiling = VK_IMAGE_TILING_OPTIMAL,
+            .usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+            .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+            .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        };
+
+        if (vkCreateImage(
+            graphics.device,
+            &imageCreateInfo,
+            nullptr,
+            &text.image
+        ) != VK_SUCCESS) std::fatal("failed to create glyph atlas");
+
+        VkMemoryRequirements requirements;
+        vkGetImageMemoryRequirements(graphics.device, text.image, &requirements);
+
+        VkMemoryAllocateInfo allocateInfo {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+            .allocationSize = requirements.size,
+            .memoryTypeIndex = findMemoryType(
+                requirements.memoryTypeBits,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+            ),
+        };
+
+        if (vkAllocateMemory(
+            graphics.device,
+            &allocateInfo,
+            nullptr,
+            &text.memory
+        ) != VK_SUCCESS) std::fatal("failed to allocate glyph atlas memory");
+
+        vkBindImageMemory(graphics.device, text.image, text.memory, 0);
+
+        VkImageSubresourceRange range {
+            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .levelCount = 1,
+            .layerCount = 1,
+        };
+
+        VkImageViewCreateInfo viewCreateInfo {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+            .image = text.image,
+            .viewType = VK_IMAGE_VIEW_TYPE_2D,
+            .format = VK_FORMAT_R8_UNORM,
+            .subresourceRange = range,
+        };
+
+        if (vkCreateImageView(
+            graphics.device,
+            &viewCreateInfo,
+            nullptr,
+            &text.view
+        ) != VK_SUCCESS) std::fatal("failed to create glyph atlas view");
+
+        VkDescriptorPoolSize poolSize {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1};
+        VkDescriptorPoolCreateInfo poolInfo {
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+            .maxSets = 1,
+            .poolSizeCount = 1,
+            .pPoolSizes = &poolSize,
+        };
+
+        if (vkCreateDescriptorPool(
+            graphics.device,
+            &poolInfo,
+            nullptr,
+            &text.descriptorPool
+        ) != VK_SUCCESS) std::fatal("failed to create glyph atlas descriptor pool");
+
+        VkDescriptorSetAllocateInfo setAllocateInfo {
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+            .descriptorPool = text.descriptorPool,
+            .descriptorSetCount = 1,
+            .pSetLayouts = &setLayout,
+        };
+
+        if (vkAllocateDescriptorSets(
+            graphics.device,
+            &setAllocateInfo,
+            &text.set
+        ) != VK_SUCCESS) std::fatal("failed to allocate glyph atlas descriptor set");
+
+        VkDescriptorImageInfo imageInfo {
+            .sampler = sampler,
+            .imageView = text.view,
+            .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        };
+
+        VkWriteDescriptorSet write {
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet = text.set,
+            .dstBinding = 0,
+            .descriptorCount = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+            .pImageInfo = &imageInfo,
+        };
+        vkUpdateDescriptorSets(graphics.device, 1, &write, 0, nullptr);
+
+        for (Buffer& staging : text.staging) {
+            staging = createBuffer(
+                Text::cellCount * cellBytes,
+                VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+            );
+        }
+
+        // Cleared to "far outside" so unused cells draw nothing.
+        VkCommandBuffer commandBuffer = beginImmediate();
+
+        VkImageMemoryBarrier2 toTransfer {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+            .srcStageMask = VK_PIPELINE_STAGE_2_NONE,
+            .dstStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+            .dstAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+            .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+            .newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image = text.image,
+            .subresourceRange = range,
+        };
+
+        VkDependencyInfo toTransferDependency {
+            .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+            .imageMemoryBarrierCount = 1,
+            .pImageMemoryBarriers = &toTransfer,
+        };
+        vkCmdPipelineBarrier2(commandBuffer, &toTransferDependency);
+
+        VkClearColorValue clear {};
+        vkCmdClearColorImage(
+            commandBuffer,
+            text.image,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            &clear,
+            1,
+            &range
+        );
+
+        VkImageMemoryBarrier2 toShader {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+            .srcStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+            .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+            .dstStageMask = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+            .dstAccessMask = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+            .oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            .newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image = text.image,
+            .subresourceRange = range,
+        };
+
+        VkDependencyInfo toShaderDependency {
+            .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+            .imageMemoryBarrierCount = 1,
+            .pImageMemoryBarriers = &toShader,
+        };
+        vkCmdPipelineBarrier2(commandBuffer, &toShaderDependency);
+
+        endImmediate(commandBuffer);
+
+        std::debug(
+            "text: {}x{} glyph atlas, {} cells of {} px",
+            Text::atlasSize,
+            Text::atlasSize,
+            Text::cellCount,
+            Text::cellSize
+        );
+    }
+
+    void deinitTextAtlas() {
+        for (Buffer const& staging : text.staging) destroyBuffer(staging);
+        vkDestroyDescriptorPool(graphics.device, text.descriptorPool, nullptr);
+        vkDestroyImageView(graphics.device, text.view, nullptr);
+        vkDestroyImage(graphics.device, text.image, nullptr);
+        vkFreeMemory(graphics.device, text.memory, nullptr);
+    }
+
+    void uploadGlyphs(VkCommandBuffer commandBuffer, u32 frameIndex) {
+        VkBufferImageCopy regions[Text::cellCount];
+        u32 count = 0;
+
+        text.mutex.lock();
+        u8* staging = (u8*)text.staging[frameIndex].mapped;
+        for (u32 i = 0; i < text.dirtyCount; i++) {
+            u32 cell = text.dirty[i];
+            text.pending[cell] = false;
+
+            u32 x0 = (cell % Text::cellsPerRow) * Text::cellSize;
+            u32 y0 = (cell / Text::cellsPerRow) * Text::cellSize;
+            for (u32 row = 0; row < Text::cellSize; row++) {
+                __builtin_memcpy(
+                    staging + count * cellBytes + row * Text::cellSize,
+                    &text.pixels[(y0 + row) * Text::atlasSize + x0],
+                    Text::cellSize
+                );
+            }
+
+            regions[count] = {
+                .bufferOffset = count * cellBytes,
+                .imageSubresource = {
+                    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                    .layerCount = 1,
+                },
+                .imageOffset = {(i32)x0, (i32)y0, 0},
+                .imageExtent = {Text::cellSize, Text::cellSize, 1},
+            };
+            count++;
+        }
+        text.dirtyCount = 0;
+        text.mutex.unlock();
+
+        if (count == 0) return;
+
+        VkImageSubresourceRange range {
+            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .levelCount = 1,
+            .layerCount = 1,
+        };
+
+        // Earlier frames may still sample the atlas, the copy waits for
+        // their fragment shaders.
+        VkImageMemoryBarrier2 toTransfer {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+            .srcStageMask = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+            .dstStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+            .dstAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+            .oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            .newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image = text.image,
+            .subresourceRange = range,
+        };
+
+        VkDependencyInfo toTransferDependency {
+            .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+            .imageMemoryBarrierCount = 1,
+            .pImageMemoryBarriers = &toTransfer,
+        };
+        vkCmdPipelineBarrier2(commandBuffer, &toTransferDependency);
+
+        vkCmdCopyBufferToImage(
+            commandBuffer,
+            text.staging[frameIndex].buffer,
+            text.image,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            count,
+            regions
+        );
+
+        VkImageMemoryBarrier2 toShader {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+            .srcStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+            .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+            .dstStageMask = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+            .dstAccessMask = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+            .oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            .newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image = text.image,
+            .subresourceRange = range,
+        };
+
+        VkDependencyInfo toShaderDependency {
+            .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+            .imageMemoryBarrierCount = 1,
+            .pImageMemoryBarriers = &toShader,
+        };
+        vkCmdPipelineBarrier2(commandBuffer, &toShaderDependency);
+    }
+}
@@ -0,0 +1,118 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+#include "igfx/graphics.h"
+#include "core/graphics.h"
+#include "core/sprites.h"
+#include "core/thread.h"
+#include "core/truetype.h"
+
+// Text is drawn as sprites. Glyphs are rasterized on demand as signed
+// distance fields into fixed cells of one R8 atlas, every cell backed by
+// a sprite table entry, so a string becomes a run of instances sharing one
+// texture and pipeline. Distances keep edges sharp when a glyph rasterized
+// at `Text::emSize` is drawn at other sizes. When the atlas is full the
+// least recently drawn cell is reused.
+//
+// Laid out strings are cached by content, unchanged labels skip UTF-8
+// decoding, cmap lookups and advances. Layout is per codepoint, there is
+// no kerning or complex shaping.
+namespace igfx::graphics {
+    struct GlyphCell {
+        u32 font; // 0 when free
+        u32 glyph;
+        u64 lastUsed; // Text::frame
+        // Glyph origin in the cell, pixels from its top left.
+        f32 originX;
+        f32 originY;
+    };
+
+    struct FontEntry {
+        truetype::Font font;
+        std::Buf<u16> cells; // per glyph, Text::noCell when not in the atlas
+        f32 ascent;     // em
+        f32 lineHeight; // em
+    };
+
+    struct LaidGlyph {
+        u32 glyph;
+        f32 x, y; // pen position in em, y down from the first baseline
+    };
+
+    struct Layout {
+        u64 hash;
+        u32 font; // 0 when unused
+        std::Buf<u8> text; // copy, hashes are only a hint
+        std::Buf<LaidGlyph> glyphs;
+        u32 glyphCount;
+        vec2 size; // em
+        u64 lastUsed;
+    };
+
+    struct Text {
+        static constexpr u32 atlasSize = 1024;
+        static constexpr u32 cellSize = 48;
+        static constexpr u32 cellsPerRow = atlasSize / cellSize;
+        static constexpr u32 cellCount = cellsPerRow * cellsPerRow;
+        static constexpr f32 emSize = 32.0f; // atlas pixels per em
+        static constexpr f32 spread = 4.0f;  // distance range each side of an edge, pixels
+        static constexpr u16 noCell = 0xffff;
+        static constexpr u32 maxFonts = 8;
+
+        // Set associative, a string hashes to a set of `layoutWays`.
+        static constexpr u32 layoutSets = 256;
+        static constexpr u32 layoutWays = 4;
+
+        FontEntry fonts[maxFonts + 1]; // 0 is no font
+        u32 fontCount;
+
+        GlyphCell cells[cellCount];
+        u32 firstSprite; // cell i is drawn as sprite firstSprite + i
+        u32 texture;
+        std::Buf<u8> pixels; // host copy of the atlas
+
+        Layout layouts[layoutSets * layoutWays];
+        bool warnedFull;
+
+        // Advanced per recorded frame. A cell is reused only once no frame
+        // still queued for rendering can draw it.
+        u64 frame;
+
+        // Cells rasterized since the last upload, taken by the render
+        // thread.
+        thread::Mutex mutex;
+        u16 dirty[cellCount];
+        u32 dirtyCount;
+        bool pending[cellCount];
+
+        // Vulkan backend.
+        VkImage image;
+        VkDeviceMemory memory;
+        VkImageView view;
+        VkDescriptorPool descriptorPool;
+        VkDescriptorSet set;
+        Buffer staging[framesInFlight];
+    };
+
+    extern Text text;
+
+    // Host side, valid for both backends.
+    void initText();
+    void deinitText();
+
+    // 0 when the font can't be loaded.
+    u32 loadFont(u8 const* path);
+
+    // Called when a frame starts recording.
+    void beginTextFrame();
+
+    void drawText(SpriteList* list, u32 font, u8 const* string, DrawTextOptions options);
+    vec2 measureText(u32 font, u8 const* string, f32 size);
+
+    void initTextAtlas(VkDescriptorSetLayout setLayout, VkSampler sampler);
+    void deinitTextAtlas();
+
+    // Copies the cells rasterized since the last call into the atlas,
+    // recorded ahead of the frame's passes.
+    void uploadGlyphs(VkCommandBuffer commandBuffer, u32 frameIndex);
+}
@@ -0,0 +1,910 @@
+#include "core/textures.h"
+#include "core/blocks.h"
+
+#include <std/alloc.h>
+#include <std/math.h>
+
+#include <stdio.h>
+
+namespace igfx::graphics {
+    Textures textures;
+
+    struct Upload {
+        Texture* texture;
+        VkImage image;
+        u32 level;
+        u32 levelCount;
+        VkDeviceSize offset; // into the frame's staging buffer
+        bool generateMips;
+    };
+
+    struct Uploads {
+        static constexpr u32 capacity = 64;
+
+        Upload entries[capacity];
+        u32 count;
+    };
+
+    inline VkFormat vkFormat(texfile::Format format) {
+        switch (format) {
+        case texfile::Format::RGBA8: return VK_FORMAT_R8G8B8A8_UNORM;
+        case texfile::Format::BC3: return VK_FORMAT_BC3_UNORM_BLOCK;
+        case texfile::Format::BC7: return VK_FORMAT_BC7_UNORM_BLOCK;
+        }
+
+        return VK_FORMAT_UNDEFINED;
+    }
+
+    inline VkExtent3D mipExtent(Texture const& texture, u32 level) {
+        return {
+            std::max(texture.width >> level, 1u),
+            std::max(texture.height >> level, 1u),
+            1,
+        };
+    }
+
+    inline usize levelSize(Texture const& texture, u32 level) {
+        VkExtent3D extent = mipExtent(texture, level);
+        return texfile::levelSize(texture.format, extent.width, extent.height);
+    }
+
+    // Bytes of mips [from, to).
+    inline usize chainBytes(Texture const& texture, u32 from, u32 to) {
+        usize bytes = 0;
+        for (u32 level = from; level < to; level++) bytes += levelSize(texture, level);
+        return bytes;
+    }
+
+    // Bytes a GPU copy of mips [level, mipCount) takes.
+    inline VkDeviceSize levelBytes(Texture const& texture, u32 level) {
+        return chainBytes(texture, level, texture.mipCount);
+    }
+
+    // Bytes staged to stream mips [level, mipCount) in.
+    inline VkDeviceSize stagedBytes(Texture const& texture, u32 level) {
+        if (texfile::compressed(texture.format)) return levelBytes(texture, level);
+        return levelSize(texture, level);
+    }
+
+    u32 addTexture(Texture texture) {
+        if (textures.count == 0) textures.count = 1;
+        if (textures.count == Textures::capacity) {
+            std::fatal("texture limit ({}) reached", Textures::capacity);
+        }
+
+        texture.residentMip = texture.mipCount;
+        textures.entries[textures.count] = texture;
+
+        textures.stats.textures = textures.count;
+        return textures.count++;
+    }
+
+    u32 createTexture(Image image) {
+        usize bytes = (usize)image.width * image.height * sizeof(u32);
+        Texture texture {
+            .width = image.width,
+            .height = image.height,
+            .mipCount = texfile::mipCount(image.width, image.height),
+            .format = texfile::Format::RGBA8,
+            .data = std::alloc<u8>(bytes),
+        };
+
+        __builtin_memcpy(texture.data.ptr, image.pixels, bytes);
+        return addTexture(texture);
+    }
+
+    u32 addExternalTexture(VkDescriptorSet set) {
+        u32 index = addTexture({.mipCount = 1, .external = true});
+        textures.entries[index].residentMip = 0;
+        textures.entries[index].set = set;
+        return index;
+    }
+
+    struct LoadJob {
+        FILE* file;
+        u8 path[256]; // for errors
+        u32 texture;
+        texfile::Format format; // as baked
+    };
+
+    void loadJob(u32, void* userData) {
+        LoadJob* job = (LoadJob*)userData;
+        defer {
+            fclose(job->file);
+            delete job;
+        };
+
+        Texture& texture = textures.entries[job->texture];
+
+        // Sampled as baked, keeping the whole chain.
+        if (textures.supported[(u32)job->format]) {
+            texture.data = std::alloc<u8>(chainBytes(texture, 0, texture.mipCount));
+            if (fread(texture.data.ptr, 1, texture.data.len, job->file) != texture.data.len) {
+                std::fatal("'{}' is truncated", job->path);
+            }
+
+            __atomic_store_n(&texture.loading, false, __ATOMIC_RELEASE);
+            return;
+        }
+
+        // Unsupported (or the software backend), decode mip 0 to RGBA8 and
+        // let the upload generate the rest.
+        auto encoded = std::alloc<u8>(levelSize(texture, 0));
+        defer { std::free(encoded); };
+        if (fread(encoded.ptr, 1, encoded.len, job->file) != encoded.len) {
+            std::fatal("'{}' is truncated", job->path);
+        }
+
+        auto data = std::alloc<u8>(
+            texfile::levelSize(texfile::Format::RGBA8, texture.width, texture.height)
+        );
+
+        if (job->format == texfile::Format::RGBA8) {
+            __builtin_memcpy(data.ptr, encoded.ptr, encoded.len);
+        } else {
+            u32* pixels = (u32*)data.ptr;
+            u8 const* block = encoded.ptr;
+            for (u32 by = 0; by < texture.height; by += 4) {
+                for (u32 bx = 0; bx < texture.width; bx += 4) {
+                    u32 texels[16];
+                    if (job->format == texfile::Format::BC7) blocks::decodeBC7(block, texels);
+                    else blocks::decodeBC3(block, texels);
+                    block += blocks::blockBytes;
+
+                    for (u32 i = 0; i < 16; i++) {
+                        u32 x = bx + i % 4, y = by + i / 4;
+                        if (x < texture.width && y < texture.height) pixels[y * texture.width + x] = texels[i];
+                    }
+                }
+            }
+        }
+
+        texture.format = texfile::Format::RGBA8;
+        texture.data = data;
+        __atomic_store_n(&texture.loading, false, __ATOMIC_RELEASE);
+    }
+
+    u32 loadTexture(u8 const* path, u32* width, u32* height) {
+        FILE* file = fopen(path, "rb");
+        if (file == nullptr) std::fatal("failed to open texture '{}'", path);
+
+        texfile::Header header;
+        if (
+            fread(&header, sizeof(header), 1, file) != 1
+            || __builtin_memcmp(header.magic, texfile::magic, sizeof(texfile::magic)) != 0
+            || header.version != texfile::version
+            || (u32)header.format >= texfile::formatCount
+            || header.mipCount != texfile::mipCount(header.width, header.height)
+        ) std::fatal("'{}' is not a texture baked by this version", path);
+
+        *width = header.width;
+        *height = header.height;
+
+        u32 index = addTexture({
+            .width = header.width,
+            .height = header.height,
+            .mipCount = header.mipCount,
+            .format = header.format,
+            .loading = true,
+        });
+        snprintf(textures.entries[index].path, sizeof(Texture::path), "%s", path);
+
+        LoadJob* job = new LoadJob {
+            .file = file,
+            .texture = index,
+            .format = header.format,
+        };
+        snprintf(job->path, sizeof(job->path), "%s", path);
+
+        jobs::submit(loadJob, job, 1, &textures.loads);
+        return index;
+    }
+
+    void waitForTextureLoads() {
+        jobs::wait(&textures.loads);
+    }
+
+    void destroyTextures() {
+        waitForTextureLoads();
+
+        for (u32 i = 1; i < textures.count; i++) {
+            if (!textures.entries[i].external) std::free(textures.entries[i].data);
+        }
+        textures.count = 0;
+    }
+
+    VkDeviceSize deviceLocalHeapSize(VkPhysicalDevice physicalDevice, u32* heapIndex) {
+        VkPhysicalDeviceMemoryProperties properties;
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice, &properties);
+
+        VkDeviceSize size = 0;
+        for (u32 i = 0; i < properties.memoryHeapCount; i++) {
+            VkMemoryHeap heap = properties.memoryHeaps[i];
+            if ((heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) && heap.size > size) {
+                size = heap.size;
+                if (heapIndex != nullptr) *heapIndex = i;
+            }
+        }
+
+        return size;
+    }
+
+    void initResidency(
+        VkDescriptorSetLayout setLayout,
+        VkSampler sampler,
+        VkDeviceSize configuredBudget
+    ) {
+        // Every texture holds one set, plus the ones retired in the frames
+        // still in flight.
+        u32 maxSets = Textures::capacity * (framesInFlight + 1);
+        VkDescriptorPoolSize poolSize {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, maxSets};
+
+        VkDescriptorPoolCreateInfo poolInfo {
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+            .flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT,
+            .maxSets = maxSets,
+            .poolSizeCount = 1,
+            .pPoolSizes = &poolSize,
+        };
+
+        if (vkCreateDescriptorPool(
+            graphics.device,
+            &poolInfo,
+            nullptr,
+            &textures.descriptorPool
+        ) != VK_SUCCESS) std::fatal("failed to create texture descriptor pool");
+
+        textures.setLayout = setLayout;
+        textures.sampler = sampler;
+        textures.heapSize = deviceLocalHeapSize(graphics.physicalDevice, &textures.heapIndex);
+        textures.configuredBudget = configuredBudget;
+        textures.residentBytes = 0;
+        textures.retiredCount = 0;
+        textures.frame = 1;
+
+        for (Buffer& staging : textures.staging) {
+            staging = createBuffer(
+                Textures::stagingBytes,
+                VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+            );
+        }
+
+        // RGBA8 sampling, transfers and linear blits are required of every
+        // Vulkan implementation, block compression needs the feature.
+        textures.supported[(u32)texfile::Format::RGBA8] = true;
+        for (texfile::Format format : {texfile::Format::BC3, texfile::Format::BC7}) {
+            VkFormatProperties properties;
+            vkGetPhysicalDeviceFormatProperties(graphics.physicalDevice, vkFormat(format), &properties);
+
+            VkFormatFeatureFlags required = VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT
+                | VK_FORMAT_FEATURE_TRANSFER_DST_BIT;
+            textures.supported[(u32)format] = graphics.textureCompressionBC
+                && (properties.optimalTilingFeatures & required) == required;
+        }
+
+        std::debug(
+            "textures: device local heap {} MiB, VK_EXT_memory_budget {}, BC3 {}, BC7 {}",
+            textures.heapSize >> 20,
+            graphics.memoryBudget ? "enabled" : "unavailable",
+            textures.supported[(u32)texfile::Format::BC3] ? "sampled" : "decoded",
+            textures.supported[(u32)texfile::Format::BC7] ? "sampled" : "decoded"
+        );
+    }
+
+    void destroyRetired(Textures::Retired const& retired) {
+        vkFreeDescriptorSets(graphics.device, textures.descriptorPool, 1, &retired.set);
+        vkDestroyImageView(graphics.device, retired.view, nullptr);
+        vkDestroyImage(graphics.device, retired.image, nullptr);
+        vkFreeMemory(graphics.device, retired.memory, nullptr);
+    }
+
+    void deinitResidency() {
+        for (u32 i = 0; i < textures.retiredCount; i++) destroyRetired(textures.retired[i]);
+
+        for (u32 i = 1; i < textures.count; i++) {
+            Texture& texture = textures.entries[i];
+            if (texture.residentMip == texture.mipCount || texture.external) continue;
+
+            destroyRetired({texture.image, texture.memory, texture.view, texture.set, 0});
+            texture.residentMip = texture.mipCount;
+            texture.set = nullptr;
+        }
+
+        for (Buffer const& staging : textures.staging) destroyBuffer(staging);
+        vkDestroyDescriptorPool(graphics.device, textures.descriptorPool, nullptr);
+    }
+
+    void touchTexture(u32 texture) {
+        if (texture == 0) return;
+
+        Texture& entry = textures.entries[texture];
+        entry.lastUsed = textures.frame;
+        if (entry.residentMip != 0) entry.wanted = true;
+    }
+
+    // What textures may occupy, the heap's budget minus everything else
+    // this process has on it. Without VK_EXT_memory_budget usage by others
+    // is unknown and a fixed share of the heap is assumed.
+    void refreshBudget() {
+        VkDeviceSize available = textures.heapSize / 10 * 8;
+
+        if (graphics.memoryBudget) {
+            VkPhysicalDeviceMemoryBudgetPropertiesEXT budget {
+                .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT,
+            };
+
+            VkPhysicalDeviceMemoryProperties2 properties {
+                .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2,
+                .pNext = &budget,
+            };
+            vkGetPhysicalDeviceMemoryProperties2(graphics.physicalDevice, &properties);
+
+            VkDeviceSize usage = budget.heapUsage[textures.heapIndex];
+            VkDeviceSize other = usage > textures.residentBytes ? usage - textures.residentBytes : 0;
+            VkDeviceSize usable = budget.heapBudget[textures.heapIndex] / 10 * 9;
+            available = usable > other ? usable - other : 0;
+        }
+
+        if (textures.configuredBudget != 0) {
+            available = std::min(available, textures.configuredBudget);
+        }
+
+        textures.budget = available;
+    }
+
+    void retire(Texture& texture) {
+        if (texture.residentMip == texture.mipCount) return;
+
+        textures.retired[textures.retiredCount++] = {
+            .image = texture.image,
+            .memory = texture.memory,
+            .view = texture.view,
+            .set = texture.set,
+            .frame = textures.frame,
+        };
+
+        textures.residentBytes -= texture.bytes;
+        texture.residentMip = texture.mipCount;
+        texture.image = nullptr;
+        texture.memory = nullptr;
+        texture.view = nullptr;
+        texture.set = nullptr;
+        texture.bytes = 0;
+    }
+
+    // Compressed levels are stored back to back on the host, one copy
+    // stages all of them. Uncompressed textures only stage their top level,
+    // filtered down from mip 0 when it is not resident.
+    void stage(Texture const& texture, u32 level, u8* dst) {
+        if (texfile::compressed(texture.format) || level == 0) {
+            __builtin_memcpy(
+                dst,
+                texture.data.ptr + chainBytes(texture, 0, level),
+                stagedBytes(texture, level)
+            );
+            return;
+        }
+
+        VkExtent3D extent = mipExtent(texture, 1);
+        auto scratch = std::alloc<u32>(extent.width * extent.height);
+        defer { std::free(scratch); };
+
+        texfile::downsample((u32 const*)texture.data.ptr, texture.width, texture.height, scratch.ptr);
+        for (u32 i = 2; i <= level; i++) {
+            VkExtent3D previous = mipExtent(texture, i - 1);
+            texfile::downsample(scratch.ptr, previous.width, previous.height, scratch.ptr);
+        }
+
+        __builtin_memcpy(dst, scratch.ptr, levelSize(texture, level));
+    }
+
+    // Replaces the GPU copy of `texture` with mips [level, mipCount),
+    // false when there is no staging space or memory left this frame.
+    bool stream(Texture& texture, u32 level, Uploads* uploads, u32 frameIndex) {
+        VkDeviceSize bytes = stagedBytes(texture, level);
+        if (
+            uploads->count == Uploads::capacity
+            || textures.stagingUsed + bytes > textures.staging[frameIndex].size
+        ) return false;
+
+        VkExtent3D extent = mipExtent(texture, level);
+        u32 levelCount = texture.mipCount - level;
+        bool generateMips = !texfile::compressed(texture.format) && levelCount > 1;
+
+        VkImageCreateInfo imageCreateInfo {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+            .imageType = VK_IMAGE_TYPE_2D,
+            .format = vkFormat(texture.format),
+            .extent = extent,
+            .mipLevels = levelCount,
+            .arrayLayers = 1,
+            .samples = VK_SAMPLE_COUNT_1_BIT,
+            .tiling = VK_IMAGE_TILING_OPTIMAL,
+            .usage = VK_IMAGE_USAGE_SAMPLED_BIT
+                | VK_IMAGE_USAGE_TRANSFER_DST_BIT
+                | (generateMips ? VK_IMAGE_USAGE_TRANSFER_SRC_BIT : 0),
+            .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+            .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        };
+
+        VkImage image;
+        if (vkCreateImage(
+            graphics.device,
+            &imageCreateInfo,
+            nullptr,
+            &image
+        ) != VK_SUCCESS) std::fatal("failed to create texture image");
+
+        VkMemoryRequirements requirements;
+        vkGetImageMemoryRequirements(graphics.device, image, &requirements);
+
+        VkMemoryAllocateInfo allocateInfo {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+            .allocationSize = requirements.size,
+            .memoryTypeIndex = findMemoryType(
+                requirements.memoryTypeBits,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+            ),
+        };
+
+        // The budget was optimistic, cap it at what fits so the next frames
+        // evict instead of failing again.
+        VkDeviceMemory memory;
+        if (vkAllocateMemory(graphics.device, &allocateInfo, nullptr, &memory) != VK_SUCCESS) {
+            vkDestroyImage(graphics.device, image, nullptr);
+            textures.configuredBudget = textures.residentBytes;
+            std::warn("out of VRAM, texture budget lowered to {} MiB", textures.residentBytes >> 20);
+            return false;
+        }
+
+        vkBindImageMemory(graphics.device, image, memory, 0);
+
+        VkImageViewCreateInfo viewCreateInfo {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+            .image = image,
+            .viewType = VK_IMAGE_VIEW_TYPE_2D,
+            .format = vkFormat(texture.format),
+            .subresourceRange = {
+                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .levelCount = levelCount,
+                .layerCount = 1,
+            },
+        };
+
+        VkImageView view;
+        if (vkCreateImageView(
+            graphics.device,
+            &viewCreateInfo,
+            nullptr,
+            &view
+        ) != VK_SUCCESS) std::fatal("failed to create texture view");
+
+        VkDescriptorSetAllocateInfo setAllocateInfo {
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+            .descriptorPool = textures.descriptorPool,
+            .descriptorSetCount = 1,
+            .pSetLayouts = &textures.setLayout,
+        };
+
+        VkDescriptorSet set;
+        if (vkAllocateDescriptorSets(
+            graphics.device,
+            &setAllocateInfo,
+            &set
+        ) != VK_SUCCESS) std::fatal("failed to allocate texture descriptor set");
+
+        VkDescriptorImageInfo imageInfo {
+            .sampler = textures.sampler,
+            .imageView = view,
+            .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        };
+
+        VkWriteDescriptorSet write {
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet = set,
+            .dstBinding = 0,
+            .descriptorCount = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+            .pImageInfo = &imageInfo,
+        };
+        vkUpdateDescriptorSets(graphics.device, 1, &write, 0, nullptr);
+
+        u8* staging = (u8*)textures.staging[frameIndex].mapped + textures.stagingUsed;
+        stage(texture, level, staging);
+
+        uploads->entries[uploads->count++] = {
+            .texture = &texture,
+            .image = image,
+            .level = level,
+            .levelCount = levelCount,
+            .offset = textures.stagingUsed,
+            .generateMips = generateMips,
+        };
+        textures.stagingUsed += bytes;
+
+        retire(texture);
+        texture.residentMip = level;
+        texture.image = image;
+        texture.memory = memory;
+        texture.view = view;
+        texture.set = set;
+        texture.bytes = requirements.size;
+        textures.residentBytes += requirements.size;
+        textures.stats.streamedBytes += bytes;
+
+        return true;
+    }
+
+    // Least recently used resident texture not drawn this frame. Textures
+    // `changed` this frame are skipped, their new image has uploads
+    // recorded into this frame and must not be retired before them.
+    Texture* leastRecentlyUsed(bool const* changed) {
+        Texture* lru = nullptr;
+        for (u32 i = 1; i < textures.count; i++) {
+            Texture& texture = textures.entries[i];
+            if (
+                texture.residentMip == texture.mipCount
+                || texture.lastUsed == textures.frame
+                || texture.external
+                || changed[i]
+            ) {
+                continue;
+            }
+
+            if (lru == nullptr || texture.lastUsed < lru->lastUsed) lru = &texture;
+        }
+
+        return lru;
+    }
+
+    // Drops the top mip of the least recently used texture, or evicts it
+    // when it has none left to drop or the lower mips can't be staged.
+    bool evictOne(Uploads* uploads, u32 frameIndex, bool* changed) {
+        Texture* texture = leastRecentlyUsed(changed);
+        if (texture == nullptr) return false;
+
+        u32 index = texture - textures.entries;
+        if (
+            texture->residentMip + 1 < texture->mipCount
+            && stream(*texture, texture->residentMip + 1, uploads, frameIndex)
+        ) {
+            changed[index] = true;
+            textures.stats.demoted++;
+            return true;
+        }
+
+        retire(*texture);
+        textures.stats.dropped++;
+        return true;
+    }
+
+    void recordUploads(VkCommandBuffer commandBuffer, Uploads const& uploads, u32 frameIndex) {
+        if (uploads.count == 0) return;
+
+        // Two per upload, generated mips leave levels in different layouts.
+        VkImageMemoryBarrier2 barriers[Uploads::capacity * 2];
+        auto barrier = [&](
+            Upload const& upload,
+            u32 baseLevel,
+            u32 levelCount,
+            VkImageLayout oldLayout,
+            VkImageLayout newLayout
+        ) -> VkImageMemoryBarrier2 {
+            auto access = [](VkImageLayout layout, VkPipelineStageFlags2* stage) -> VkAccessFlags2 {
+                switch (layout) {
+                case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL:
+                    *stage = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+                    return VK_ACCESS_2_TRANSFER_WRITE_BIT;
+                case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL:
+                    *stage = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+                    return VK_ACCESS_2_TRANSFER_READ_BIT;
+                case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
+                    *stage = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
+                    return VK_ACCESS_2_SHADER_SAMPLED_READ_BIT;
+                default:
+                    *stage = VK_PIPELINE_STAGE_2_NONE;
+                    return VK_ACCESS_2_NONE;
+                }
+            };
+
+            VkImageMemoryBarrier2 result {
+                .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+                .oldLayout = oldLayout,
+                .newLayout = newLayout,
+                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .image = upload.image,
+                .subresourceRange = {
+                    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                    .baseMipLevel = baseLevel,
+                    .levelCount = levelCount,
+                    .layerCount = 1,
+                },
+            };
+            result.srcAccessMask = access(oldLayout, &result.srcStageMask);
+            result.dstAccessMask = access(newLayout, &result.dstStageMask);
+            return result;
+        };
+
+        auto submitBarriers = [&](u32 count) {
+            VkDependencyInfo dependency {
+                .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+                .imageMemoryBarrierCount = count,
+                .pImageMemoryBarriers = barriers,
+            };
+            vkCmdPipelineBarrier2(commandBuffer, &dependency);
+        };
+
+        for (u32 i = 0; i < uploads.count; i++) {
+            Upload const& upload = uploads.entries[i];
+            barriers[i] = barrier(
+                upload,
+                0,
+                upload.levelCount,
+                VK_IMAGE_LAYOUT_UNDEFINED,
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
+            );
+        }
+        submitBarriers(uploads.count);
+
+        for (u32 i = 0; i < uploads.count; i++) {
+            Upload const& upload = uploads.entries[i];
+            Texture const& texture = *upload.texture;
+
+            VkBufferImageCopy regions[texfile::maxMips];
+            u32 regionCount = upload.generateMips ? 1 : upload.levelCount;
+            for (u32 r = 0; r < regionCount; r++) {
+                regions[r] = {
+                    .bufferOffset = upload.offset
+                        + chainBytes(texture, upload.level, upload.level + r),
+                    .imageSubresource = {
+                        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                        .mipLevel = r,
+                        .layerCount = 1,
+                    },
+                    .imageExtent = mipExtent(texture, upload.level + r),
+                };
+            }
+
+            vkCmdCopyBufferToImage(
+                commandBuffer,
+                textures.staging[frameIndex].buffer,
+                upload.image,
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                regionCount,
+                regions
+            );
+        }
+
+        // Mips are generated a level at a time across all uploads, each
+        // filtered from the one above it.
+        for (u32 level = 1; level < texfile::maxMips; level++) {
+            u32 count = 0;
+            for (u32 i = 0; i < uploads.count; i++) {
+                Upload const& upload = uploads.entries[i];
+                if (!upload.generateMips || level >= upload.levelCount) continue;
+
+                barriers[count++] = barrier(
+                    upload,
+                    level - 1,
+                    1,
+                    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                    VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL
+                );
+            }
+
+            if (count == 0) break;
+            submitBarriers(count);
+
+            for (u32 i = 0; i < uploads.count; i++) {
+                Upload const& upload = uploads.entries[i];
+                if (!upload.generateMips || level >= upload.levelCount) continue;
+
+                VkExtent3D src = mipExtent(*upload.texture, upload.level + level - 1);
+                VkExtent3D dst = mipExtent(*upload.texture, upload.level + level);
+
+                VkImageBlit blit {
+                    .srcSubresource = {
+                        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                        .mipLevel = level - 1,
+                        .layerCount = 1,
+                    },
+                    .srcOffsets = {{0, 0, 0}, {(i32)src.width, (i32)src.height, 1}},
+                    .dstSubresource = {
+                        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                        .mipLevel = level,
+                        .layerCount = 1,
+                    },
+                    .dstOffsets = {{0, 0, 0}, {(i32)dst.width, (i32)dst.height, 1}},
+                };
+
+                vkCmdBlitImage(
+                    commandBuffer,
+                    upload.image,
+                    VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                    upload.image,
+                    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                    1,
+                    &blit,
+                    VK_FILTER_LINEAR
+                );
+            }
+        }
+
+        u32 count = 0;
+        for (u32 i = 0; i < uploads.count; i++) {
+            Upload const& upload = uploads.entries[i];
+            u32 last = upload.levelCount - 1;
+
+            if (upload.generateMips) {
+                barriers[count++] = barrier(
+                    upload,
+                    0,
+                    last,
+                    VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+                );
+                barriers[count++] = barrier(
+                    upload,
+                    last,
+                    1,
+                    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+                );
+            } else {
+                barriers[count++] = barrier(
+                    upload,
+                    0,
+                    upload.levelCount,
+                    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+                );
+            }
+        }
+        submitBarriers(count);
+    }
+
+    // Makes the frame's staging buffer hold the full upload of every texture
+    // drawn, its previous contents were consumed (the frame's fence was
+    // waited on).
+    void growStaging(u32 frameIndex) {
+        Buffer& staging = textures.staging[frameIndex];
+
+        VkDeviceSize needed = staging.size;
+        for (u32 i = 1; i < textures.count; i++) {
+            Texture& texture = textures.entries[i];
+            if (!texture.wanted || __atomic_load_n(&texture.loading, __ATOMIC_ACQUIRE)) continue;
+
+            VkDeviceSize bytes = stagedBytes(texture, 0);
+            if (bytes <= staging.size) continue;
+
+            if (!texture.warnedStaging) {
+                texture.warnedStaging = true;
+                std::warn(
+                    "texture {} ({}x{}) needs {} MiB of staging, more than the {} MiB per frame",
+                    i,
+                    texture.width,
+                    texture.height,
+                    bytes >> 20,
+                    staging.size >> 20
+                );
+            }
+
+            needed = std::max(needed, bytes);
+        }
+
+        if (needed == staging.size) return;
+
+        destroyBuffer(staging);
+        staging = createBuffer(
+            (needed + (1 << 20) - 1) & ~(VkDeviceSize)((1 << 20) - 1),
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+        );
+    }
+
+    void updateResidency(VkCommandBuffer commandBuffer, u32 frameIndex) {
+        // The fence of this frame slot was waited on, everything retired
+        // before the previous frame was recorded is no longer in use.
+        u32 kept = 0;
+        for (u32 i = 0; i < textures.retiredCount; i++) {
+            Textures::Retired const& retired = textures.retired[i];
+            if (retired.frame + framesInFlight - 1 <= textures.frame) {
+                destroyRetired(retired);
+            } else {
+                textures.retired[kept++] = retired;
+            }
+        }
+        textures.retiredCount = kept;
+
+        refreshBudget();
+
+        TextureStats& stats = textures.stats;
+        stats.streamed = 0;
+        stats.streamedBytes = 0;
+        stats.demoted = 0;
+        stats.dropped = 0;
+
+        Uploads uploads;
+        uploads.count = 0;
+        textures.stagingUsed = 0;
+
+        bool changed[Textures::capacity] = {};
+
+        growStaging(frameIndex);
+
+        // Over budget (e.g. it shrank), make room before streaming.
+        while (
+            textures.residentBytes > textures.budget
+            && evictOne(&uploads, frameIndex, changed)
+        );
+
+        // Textures drawn this frame get the most mips that fit, evicting
+        // less recently used ones as needed.
+        for (u32 i = 1; i < textures.count; i++) {
+            Texture& texture = textures.entries[i];
+            if (!texture.wanted) continue;
+            // Still wanted once its payload is in.
+            if (__atomic_load_n(&texture.loading, __ATOMIC_ACQUIRE)) continue;
+            if (uploads.count == Uploads::capacity) break;
+
+            // Staging is shared by the frame's uploads, stream the mips that
+            // fit what is left (the rest follows in later frames while it
+            // is drawn). Nothing is evicted for a texture that can't stream.
+            VkDeviceSize stagingFree = textures.staging[frameIndex].size - textures.stagingUsed;
+            u32 first = 0;
+            while (first < texture.residentMip && stagedBytes(texture, first) > stagingFree) first++;
+            if (first == texture.residentMip) continue;
+
+            texture.wanted = false;
+
+            u32 level = first;
+            for (; level < texture.residentMip; level++) {
+                VkDeviceSize needed = textures.residentBytes - texture.bytes + levelBytes(texture, level);
+                while (needed > textures.budget && evictOne(&uploads, frameIndex, changed)) {
+                    needed = textures.residentBytes - texture.bytes + levelBytes(texture, level);
+                }
+
+                if (needed <= textures.budget) break;
+            }
+
+            if (level < texture.residentMip && stream(texture, level, &uploads, frameIndex)) {
+                changed[i] = true;
+                stats.streamed++;
+            }
+        }
+
+        recordUploads(commandBuffer, uploads, frameIndex);
+
+        stats.textures = textures.count > 0 ? textures.count - 1 : 0;
+        stats.resident = 0;
+        stats.partial = 0;
+        stats.evicted = 0;
+        for (u32 i = 1; i < textures.count; i++) {
+            Texture const& texture = textures.entries[i];
+            if (texture.residentMip == 0) stats.resident++;
+            else if (texture.residentMip < texture.mipCount) stats.partial++;
+            else stats.evicted++;
+        }
+        stats.residentBytes = textures.residentBytes;
+        stats.budgetBytes = textures.budget;
+
+        if (stats.streamed + stats.demoted + stats.dropped > 0) {
+            std::debug(
+                "textures: {} resident, {} partial, {} evicted, {}/{} MiB, streamed {} ({} KiB), demoted {}, dropped {}",
+                stats.resident,
+                stats.partial,
+                stats.evicted,
+                stats.residentBytes >> 20,
+                stats.budgetBytes >> 20,
+                stats.streamed,
+                stats.streamedBytes >> 10,
+                stats.demoted,
+                stats.dropped
+            );
+        }
+
+        textures.frame++;
+    }
+}
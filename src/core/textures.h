@@ -0,0 +1,125 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <std/slice.h>
+
+#include "igfx/graphics.h"
+#include "core/graphics.h"
+#include "core/texfile.h"
+#include "core/jobs.h"
+
+// Textures keep a host copy and are made resident in VRAM on demand, baked
+// block compressed textures keep their whole mip chain, uncompressed ones
+// mip 0 with the rest generated by vkCmdBlitImage on upload. Every frame
+// the textures drawn are stamped, and when the device local heap is over
+// budget the least recently used ones are dropped to a lower mip, then out
+// of VRAM, to make room. Dropped textures are streamed back in from the
+// host copy the next time they are drawn.
+namespace igfx::graphics {
+    struct Texture {
+        u32 width;
+        u32 height;
+        u32 mipCount;
+        texfile::Format format;
+        std::Buf<u8> data;
+
+        // Mips [residentMip, mipCount) are in VRAM, none when equal to
+        // `mipCount`.
+        u32 residentMip;
+        VkImage image;
+        VkDeviceMemory memory;
+        VkImageView view;
+        VkDescriptorSet set;
+        VkDeviceSize bytes;
+
+        u64 lastUsed;
+        bool wanted; // drawn this frame while not fully resident
+        bool external; // owned elsewhere (the glyph atlas), always resident
+        // Set while a job reads the host copy (`loadTexture`), atomic.
+        bool loading;
+        bool warnedStaging; // grew the staging buffers
+        u8 path[256]; // `loadTexture`'s, empty otherwise (for captures)
+    };
+
+    struct Textures {
+        // Index 0 is the default sprite's white texture owned by the
+        // sprite batch, it is never evicted.
+        static constexpr u32 capacity = 1024;
+        // Per frame, grown when a texture's largest upload doesn't fit.
+        static constexpr VkDeviceSize stagingBytes = 16 << 20;
+
+        Texture entries[capacity];
+        u32 count;
+
+        // Payloads of loaded textures being read and decoded.
+        jobs::Counter loads;
+
+        VkDescriptorSetLayout setLayout;
+        VkDescriptorPool descriptorPool;
+        VkSampler sampler;
+
+        u32 heapIndex;
+        VkDeviceSize heapSize;
+        VkDeviceSize configuredBudget;
+        VkDeviceSize budget;
+        VkDeviceSize residentBytes;
+
+        Buffer staging[framesInFlight];
+        VkDeviceSize stagingUsed;
+
+        // Replaced GPU copies are destroyed once the frames that may still
+        // sample them have completed.
+        struct Retired {
+            VkImage image;
+            VkDeviceMemory memory;
+            VkImageView view;
+            VkDescriptorSet set;
+            u64 frame;
+        };
+
+        Retired retired[capacity * framesInFlight];
+        u32 retiredCount;
+
+        // Baked formats the device samples, others are decoded to RGBA8.
+        bool supported[texfile::formatCount];
+
+        u64 frame;
+        TextureStats stats;
+    };
+
+    extern Textures textures;
+
+    // Host side only, valid for both backends.
+    u32 createTexture(Image image);
+    // Loads a texture baked by `bake`, fatal when it can't be read. Only
+    // the header is read here, the payload is read (and decoded when
+    // unsupported) on a job thread, the texture is drawn white until then.
+    u32 loadTexture(u8 const* path, u32* width, u32* height);
+    // Waits for every `loadTexture` payload, helping run jobs.
+    void waitForTextureLoads();
+    // A texture whose image is managed by its owner, drawn with `set`.
+    u32 addExternalTexture(VkDescriptorSet set);
+    void destroyTextures();
+
+    // The heap textures are allocated from, for device selection.
+    VkDeviceSize deviceLocalHeapSize(VkPhysicalDevice physicalDevice, u32* heapIndex);
+
+    void initResidency(
+        VkDescriptorSetLayout setLayout,
+        VkSampler sampler,
+        VkDeviceSize configuredBudget
+    );
+    void deinitResidency();
+
+    // Stamps `texture` as drawn this frame.
+    void touchTexture(u32 texture);
+
+    // Frees retired copies, refreshes the budget and makes room for and
+    // streams in the textures touched this frame. Uploads are recorded
+    // into `commandBuffer` ahead of the frame's passes.
+    void updateResidency(VkCommandBuffer commandBuffer, u32 frameIndex);
+
+    // Set to draw `texture` with, nullptr when it is not resident.
+    inline VkDescriptorSet textureSet(u32 texture) {
+        return textures.entries[texture].set;
+    }
+}
@@ -0,0 +1,111 @@
+#include "core/thread.h"
+
+#if _WIN32
+#include <windows.h>
+using NativeMutex = SRWLOCK;
+using NativeCondition = CONDITION_VARIABLE;
+#else
+#include <pthread.h>
+#include <unistd.h>
+using NativeMutex = pthread_mutex_t;
+using NativeCondition = pthread_cond_t;
+#endif
+
+namespace igfx::thread {
+    static_assert(sizeof(NativeMutex) <= sizeof(Mutex::storage));
+    static_assert(sizeof(NativeCondition) <= sizeof(Condition::storage));
+
+    struct Start {
+        ThreadFn fn;
+        void* arg;
+    };
+
+#if _WIN32
+    DWORD WINAPI threadMain(void* start) {
+        Start s = *(Start*)start;
+        delete (Start*)start;
+
+        s.fn(s.arg);
+        return 0;
+    }
+
+    Thread spawn(ThreadFn fn, void* arg) {
+        HANDLE handle = CreateThread(nullptr, 0, threadMain, new Start {fn, arg}, 0, nullptr);
+        if (handle == nullptr) std::fatal("failed to spawn a thread");
+
+        return {handle};
+    }
+
+    void join(Thread thread) {
+        WaitForSingleObject((HANDLE)thread.handle, INFINITE);
+        CloseHandle((HANDLE)thread.handle);
+    }
+
+    u32 cpuCount() {
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        return info.dwNumberOfProcessors;
+    }
+
+    void Mutex::init() { InitializeSRWLock((SRWLOCK*)storage); }
+    void Mutex::deinit() {}
+    void Mutex::lock() { AcquireSRWLockExclusive((SRWLOCK*)storage); }
+    void Mutex::unlock() { ReleaseSRWLockExclusive((SRWLOCK*)storage); }
+
+    void Condition::init() { InitializeConditionVariable((CONDITION_VARIABLE*)storage); }
+    void Condition::deinit() {}
+
+    void Condition::wait(Mutex* mutex) {
+        SleepConditionVariableSRW(
+            (CONDITION_VARIABLE*)storage,
+            (SRWLOCK*)mutex->storage,
+            INFINITE,
+            0
+        );
+    }
+
+    void Condition::signal() { WakeConditionVariable((CONDITION_VARIABLE*)storage); }
+    void Condition::broadcast() { WakeAllConditionVariable((CONDITION_VARIABLE*)storage); }
+#else
+    void* threadMain(void* start) {
+        Start s = *(Start*)start;
+        delete (Start*)start;
+
+        s.fn(s.arg);
+        return nullptr;
+    }
+
+    Thread spawn(ThreadFn fn, void* arg) {
+        pthread_t handle;
+        if (pthread_create(&handle, nullptr, threadMain, new Start {fn, arg}) != 0) {
+            std::fatal("failed to spawn a thread");
+        }
+
+        return {(void*)handle};
+    }
+
+    void join(Thread thread) {
+        pthread_join((pthread_t)thread.handle, nullptr);
+    }
+
+    u32 cpuCount() {
+        i64 count = sysconf(_SC_NPROCESSORS_ONLN);
+        return count > 0 ? (u32)count : 1;
+    }
+
+    void Mutex::init() { pthread_mutex_init((pthread_mutex_t*)storage, nullptr); }
+    void Mutex::deinit() { pthread_mutex_destroy((pthread_mutex_t*)storage); }
+    void Mutex::lock() { pthread_mutex_lock((pthread_mutex_t*)storage); }
+    void Mutex::unlock() { pthread_mutex_unlock((pthread_mutex_t*)storage); }
+
+    void Condition::init() { pthread_cond_init((pthread_cond_t*)storage, nullptr); }
+    void Condition::deinit() { pthread_cond_destroy((pthread_cond_t*)storage); }
+
+    void Condition::wait(Mutex* mutex) {
+        pthread_cond_wait((pthread_cond_t*)storage, (pthread_mutex_t*)mutex->storage);
+    }
+
+    void Condition::signal() { pthread_cond_signal((pthread_cond_t*)storage); }
+    void Condition::broadcast() { pthread_cond_broadcast((pthread_cond_t*)storage); }
+#endif
+}
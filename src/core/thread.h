@@ -0,0 +1,34 @@
+#pragma once
+
+namespace igfx::thread {
+    using ThreadFn = void(*)(void*);
+
+    struct Thread {
+        void* handle;
+    };
+
+    Thread spawn(ThreadFn fn, void* arg);
+    void join(Thread);
+
+    u32 cpuCount();
+
+    // Storage is opaque so platform headers stay out of the includes.
+    struct Mutex {
+        alignas(16) u8 storage[64];
+
+        void init();
+        void deinit();
+        void lock();
+        void unlock();
+    };
+
+    struct Condition {
+        alignas(16) u8 storage[64];
+
+        void init();
+        void deinit();
+        void wait(Mutex*);
+        void signal();
+        void broadcast();
+    };
+}
@@ -0,0 +1,38 @@
+#include "core/timer.h"
+
+#if _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+namespace igfx::timer {
+#if _WIN32
+    f64 now() {
+        LARGE_INTEGER frequency, counter;
+        QueryPerformanceFrequency(&frequency);
+        QueryPerformanceCounter(&counter);
+        return (f64)counter.QuadPart / (f64)frequency.QuadPart;
+    }
+
+    void sleep(f64 seconds) {
+        if (seconds > 0.0) Sleep((DWORD)(seconds * 1e3));
+    }
+#else
+    f64 now() {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (f64)ts.tv_sec + (f64)ts.tv_nsec * 1e-9;
+    }
+
+    void sleep(f64 seconds) {
+        if (seconds <= 0.0) return;
+
+        timespec ts {
+            .tv_sec = (time_t)seconds,
+            .tv_nsec = (long)((seconds - (f64)(time_t)seconds) * 1e9),
+        };
+        nanosleep(&ts, nullptr);
+    }
+#endif
+}
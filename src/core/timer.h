@@ -0,0 +1,8 @@
+#pragma once
+
+namespace igfx::timer {
+    // Monotonic time in seconds.
+    f64 now();
+
+    void sleep(f64 seconds);
+}
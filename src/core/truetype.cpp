@@ -0,0 +1,512 @@
+#include "core/truetype.h"
+
+#include <std/alloc.h>
+#include <std/math.h>
+
+#include <stdio.h>
+
+namespace igfx::truetype {
+    // Fonts are big endian, u8 is a plain (possibly signed) char.
+    inline u32 u8At(u8 const* p) {
+        return (unsigned char)p[0];
+    }
+
+    inline u32 u16At(u8 const* p) {
+        return (u8At(p) << 8) | u8At(p + 1);
+    }
+
+    inline i32 i16At(u8 const* p) {
+        return (i16)u16At(p);
+    }
+
+    inline u32 u32At(u8 const* p) {
+        return (u16At(p) << 16) | u16At(p + 2);
+    }
+
+    // 2.14 fixed point.
+    inline f32 f2dot14At(u8 const* p) {
+        return i16At(p) / 16384.0f;
+    }
+
+    inline u32 tag(char const (&name)[5]) {
+        return ((u32)name[0] << 24) | ((u32)name[1] << 16) | ((u32)name[2] << 8) | (u32)name[3];
+    }
+
+    // Offset of table `name`, 0 when missing, out of bounds or shorter
+    // than `minLength`.
+    u32 findTable(std::Buf<u8> data, u32 name, u32 minLength, u32* length = nullptr) {
+        u32 count = u16At(data.ptr + 4);
+        if (12 + count * 16 > data.len) return 0;
+
+        for (u32 i = 0; i < count; i++) {
+            u8 const* record = data.ptr + 12 + i * 16;
+            if (u32At(record) != name) continue;
+
+            u32 offset = u32At(record + 8);
+            u32 tableLength = u32At(record + 12);
+            if (offset == 0 || tableLength < minLength || (u64)offset + tableLength > data.len) return 0;
+
+            if (length != nullptr) *length = tableLength;
+            return offset;
+        }
+
+        return 0;
+    }
+
+    // Whether the cmap subtable at `subtable` holds its segment or group
+    // arrays before `end`.
+    bool validSubtable(u8 const* data, u32 subtable, u32 end, u32 format) {
+        if (format == 12) {
+            if ((u64)subtable + 16 > end) return false;
+            return (u64)subtable + 16 + (u64)u32At(data + subtable + 12) * 12 <= end;
+        }
+
+        if ((u64)subtable + 14 > end) return false;
+        u32 segments = u16At(data + subtable + 6) / 2;
+        return (u64)subtable + 16 + segments * 8 <= end;
+    }
+
+    bool load(Font* font, u8 const* path) {
+        FILE* file = fopen(path, "rb");
+        if (file == nullptr) {
+            std::warn("failed to open font '{}'", path);
+            return false;
+        }
+        defer { fclose(file); };
+
+        fseek(file, 0, SEEK_END);
+        long size = ftell(file);
+        fseek(file, 0, SEEK_SET);
+        if (size < 12) {
+            std::warn("'{}' is not a TrueType font", path);
+            return false;
+        }
+
+        std::Buf<u8> data = std::alloc<u8>(size);
+        if (fread(data.ptr, 1, data.len, file) != data.len) {
+            std::free(data);
+            std::warn("failed to read font '{}'", path);
+            return false;
+        }
+
+        u32 cmapLength, locaLength, hmtxLength, glyfLength;
+        u32 head = findTable(data, tag("head"), 54);
+        u32 hhea = findTable(data, tag("hhea"), 36);
+        u32 maxp = findTable(data, tag("maxp"), 6);
+        u32 cmap = findTable(data, tag("cmap"), 4, &cmapLength);
+
+        *font = {
+            .data = data,
+            .glyf = findTable(data, tag("glyf"), 0, &glyfLength),
+            .loca = findTable(data, tag("loca"), 0, &locaLength),
+            .hmtx = findTable(data, tag("hmtx"), 0, &hmtxLength),
+        };
+
+        if (
+            (u32At(data.ptr) != 0x00010000 && u32At(data.ptr) != tag("true"))
+            || head == 0 || hhea == 0 || maxp == 0 || cmap == 0
+            || font->glyf == 0 || font->loca == 0 || font->hmtx == 0
+        ) {
+            std::warn("'{}' is not a TrueType font with glyf outlines", path);
+            std::free(data);
+            return false;
+        }
+
+        font->glyfLength = glyfLength;
+        font->cmapEnd = cmap + cmapLength;
+        font->unitsPerEm = u16At(data.ptr + head + 18);
+        font->longLoca = i16At(data.ptr + head + 50) != 0;
+        font->ascent = i16At(data.ptr + hhea + 4);
+        font->descent = i16At(data.ptr + hhea + 6);
+        font->lineGap = i16At(data.ptr + hhea + 8);
+        font->hMetricCount = u16At(data.ptr + hhea + 34);
+        font->glyphCount = u16At(data.ptr + maxp + 4);
+
+        u32 locaEntry = font->longLoca ? 4 : 2;
+        if (
+            (u64)(font->glyphCount + 1) * locaEntry > locaLength
+            || (u64)font->hMetricCount * 4 > hmtxLength
+        ) {
+            std::warn("'{}' has tables too short for its {} glyphs", path, font->glyphCount);
+            std::free(data);
+            return false;
+        }
+
+        // Full unicode (format 12) over the basic plane (format 4).
+        u32 records = std::min(u16At(data.ptr + cmap + 2), (cmapLength - 4) / 8);
+        for (u32 i = 0; i < records; i++) {
+            u8 const* record = data.ptr + cmap + 4 + i * 8;
+            u32 platform = u16At(record);
+            u32 encoding = u16At(record + 2);
+            if (platform != 0 && !(platform == 3 && (encoding == 1 || encoding == 10))) continue;
+
+            u64 subtable = (u64)cmap + u32At(record + 4);
+            if (subtable + 2 > font->cmapEnd) continue;
+
+            u32 format = u16At(data.ptr + subtable);
+            if (format != 4 && format != 12) continue;
+            if (!validSubtable(data.ptr, (u32)subtable, font->cmapEnd, format)) continue;
+
+            if (format == 12 || font->cmapFormat != 12) {
+                font->cmap = (u32)subtable;
+                font->cmapFormat = format;
+            }
+        }
+
+        if (font->cmapFormat == 0 || font->unitsPerEm == 0 || font->hMetricCount == 0) {
+            std::warn("'{}' has no unicode character map", path);
+            std::free(data);
+            return false;
+        }
+
+        return true;
+    }
+
+    void unload(Font* font) {
+        std::free(font->data);
+        *font = {};
+    }
+
+    // Array lengths were checked by `validSubtable` at load.
+    u32 mappedGlyph(Font const& font, u32 codepoint) {
+        u8 const* table = font.data.ptr + font.cmap;
+
+        if (font.cmapFormat == 12) {
+            u32 groups = u32At(table + 12);
+            for (u32 lo = 0, hi = groups; lo < hi;) {
+                u32 mid = (lo + hi) / 2;
+                u8 const* group = table + 16 + mid * 12;
+                if (codepoint < u32At(group)) hi = mid;
+                else if (codepoint > u32At(group + 4)) lo = mid + 1;
+                else return u32At(group + 8) + codepoint - u32At(group);
+            }
+
+            return 0;
+        }
+
+        if (codepoint > 0xffff) return 0;
+
+        u32 segments = u16At(table + 6) / 2;
+        u8 const* endCodes = table + 14;
+        u8 const* startCodes = endCodes + segments * 2 + 2;
+        u8 const* deltas = startCodes + segments * 2;
+        u8 const* rangeOffsets = deltas + segments * 2;
+
+        for (u32 lo = 0, hi = segments; lo < hi;) {
+            u32 mid = (lo + hi) / 2;
+            if (codepoint > u16At(endCodes + mid * 2)) {
+                lo = mid + 1;
+                continue;
+            }
+
+            if (mid > 0 && codepoint <= u16At(endCodes + (mid - 1) * 2)) {
+                hi = mid;
+                continue;
+            }
+
+            u32 start = u16At(startCodes + mid * 2);
+            if (codepoint < start) return 0;
+
+            u32 delta = u16At(deltas + mid * 2);
+            u32 rangeOffset = u16At(rangeOffsets + mid * 2);
+            if (rangeOffset == 0) return (codepoint + delta) & 0xffff;
+
+            // Relative to the range offset's own position.
+            u8 const* glyph = rangeOffsets + mid * 2 + rangeOffset + (codepoint - start) * 2;
+            if (glyph + 2 > font.data.ptr + font.cmapEnd) return 0;
+
+            u32 index = u16At(glyph);
+            return index == 0 ? 0 : (index + delta) & 0xffff;
+        }
+
+        return 0;
+    }
+
+    u32 glyphIndex(Font const& font, u32 codepoint) {
+        u32 glyph = mappedGlyph(font, codepoint);
+        return glyph < font.glyphCount ? glyph : 0;
+    }
+
+    u32 advance(Font const& font, u32 glyph) {
+        u32 metric = std::min(glyph, font.hMetricCount - 1);
+        return u16At(font.data.ptr + font.hmtx + metric * 4);
+    }
+
+    // The glyph's data in glyf, nullptr when it has no outline. `*end` is
+    // set past its last byte, the header (10 bytes) is always there.
+    u8 const* glyphData(Font const& font, u32 glyph, u8 const** end) {
+        if (glyph >= font.glyphCount) return nullptr;
+
+        u8 const* loca = font.data.ptr + font.loca;
+        u32 start, stop;
+        if (font.longLoca) {
+            start = u32At(loca + glyph * 4);
+            stop = u32At(loca + glyph * 4 + 4);
+        } else {
+            start = u16At(loca + glyph * 2) * 2;
+            stop = u16At(loca + glyph * 2 + 2) * 2;
+        }
+
+        if (stop <= start || stop - start < 10 || stop > font.glyfLength) return nullptr;
+
+        *end = font.data.ptr + font.glyf + stop;
+        return font.data.ptr + font.glyf + start;
+    }
+
+    bool box(Font const& font, u32 glyph, GlyphBox* box) {
+        u8 const* end;
+        u8 const* data = glyphData(font, glyph, &end);
+        if (data == nullptr) return false;
+
+        *box = {i16At(data + 2), i16At(data + 4), i16At(data + 6), i16At(data + 8)};
+        return box->xMax > box->xMin && box->yMax > box->yMin;
+    }
+
+    // x' = a x + c y + e, y' = b x + d y + f
+    struct Transform {
+        f32 a, b, c, d, e, f;
+    };
+
+    struct Outline {
+        std::Slice<Segment> segments;
+        u32 count;
+    };
+
+    struct Point {
+        f32 x, y;
+        bool onCurve;
+    };
+
+    inline Point apply(Transform const& t, f32 x, f32 y) {
+        return {t.a * x + t.c * y + t.e, t.b * x + t.d * y + t.f, true};
+    }
+
+    inline Point midpoint(Point p, Point q) {
+        return {(p.x + q.x) * 0.5f, (p.y + q.y) * 0.5f, true};
+    }
+
+    inline void line(Outline* outline, Point p, Point q) {
+        if (outline->count == outline->segments.len) return;
+        outline->segments[outline->count++] = {p.x, p.y, q.x, q.y};
+    }
+
+    // Pieces scale with the curve's length, a few per em is plenty at
+    // atlas sizes.
+    void quadratic(Outline* outline, Point p, Point control, Point q) {
+        f32 length = __builtin_fabsf(control.x - p.x) + __builtin_fabsf(control.y - p.y)
+            + __builtin_fabsf(q.x - control.x) + __builtin_fabsf(q.y - control.y);
+        u32 pieces = std::clamp((u32)(length / 64.0f), 2u, 16u);
+
+        Point previous = p;
+        for (u32 i = 1; i <= pieces; i++) {
+            f32 t = (f32)i / pieces;
+            f32 u = 1.0f - t;
+            Point next {
+                u * u * p.x + 2.0f * u * t * control.x + t * t * q.x,
+                u * u * p.y + 2.0f * u * t * control.y + t * t * q.y,
+                true,
+            };
+
+            line(outline, previous, next);
+            previous = next;
+        }
+    }
+
+    // Off curve points in a row have an implied on curve point between
+    // them, a contour may start off curve.
+    void contour(Outline* outline, Point const* points, u32 count) {
+        if (count < 2) return;
+
+        Point first = points[0], last = points[count - 1];
+        Point start = first.onCurve ? first : last.onCurve ? last : midpoint(first, last);
+
+        Point current = start, control;
+        bool hasControl = false;
+        for (u32 i = 0; i < count; i++) {
+            if (i == 0 && first.onCurve) continue;
+            if (i == count - 1 && !first.onCurve && last.onCurve) continue;
+
+            Point point = points[i];
+            if (point.onCurve) {
+                if (hasControl) quadratic(outline, current, control, point);
+                else line(outline, current, point);
+
+                current = point;
+                hasControl = false;
+            } else {
+                if (hasControl) {
+                    Point implied = midpoint(control, point);
+                    quadratic(outline, current, control, implied);
+                    current = implied;
+                }
+
+                control = point;
+                hasControl = true;
+            }
+        }
+
+        if (hasControl) quadratic(outline, current, control, start);
+        else line(outline, current, start);
+    }
+
+    // Adds nothing when a stream runs past `end`.
+    void simpleGlyph(
+        u8 const* data,
+        u8 const* end,
+        u32 contours,
+        Transform const& transform,
+        Outline* outline
+    ) {
+        u8 const* endPoints = data + 10;
+        if ((usize)(end - endPoints) < contours * 2 + 2) return;
+
+        u32 pointCount = u16At(endPoints + (contours - 1) * 2) + 1;
+        u32 instructions = u16At(endPoints + contours * 2);
+        u8 const* p = endPoints + contours * 2 + 2;
+        if (instructions > (usize)(end - p)) return;
+        p += instructions;
+
+        auto points = std::alloc<Point>(pointCount);
+        defer { std::free(points); };
+
+        auto flags = std::alloc<u8>(pointCount);
+        defer { std::free(flags); };
+
+        for (u32 i = 0; i < pointCount;) {
+            if (p == end) return;
+
+            u32 flag = u8At(p++);
+            if ((flag & 8) && p == end) return;
+
+            u32 repeat = (flag & 8) ? u8At(p++) + 1 : 1;
+            for (u32 r = 0; r < repeat && i < pointCount; r++) flags[i++] = flag;
+        }
+
+        i32 x = 0;
+        for (u32 i = 0; i < pointCount; i++) {
+            u32 flag = u8At(&flags[i]);
+            if (flag & 2) {
+                if (p + 1 > end) return;
+
+                i32 dx = u8At(p++);
+                x += (flag & 16) ? dx : -dx;
+            } else if (!(flag & 16)) {
+                if (p + 2 > end) return;
+
+                x += i16At(p);
+                p += 2;
+            }
+
+            points[i].x = x;
+            points[i].onCurve = flag & 1;
+        }
+
+        i32 y = 0;
+        for (u32 i = 0; i < pointCount; i++) {
+            u32 flag = u8At(&flags[i]);
+            if (flag & 4) {
+                if (p + 1 > end) return;
+
+                i32 dy = u8At(p++);
+                y += (flag & 32) ? dy : -dy;
+            } else if (!(flag & 32)) {
+                if (p + 2 > end) return;
+
+                y += i16At(p);
+                p += 2;
+            }
+
+            Point transformed = apply(transform, points[i].x, y);
+            points[i].x = transformed.x;
+            points[i].y = transformed.y;
+        }
+
+        u32 start = 0;
+        for (u32 c = 0; c < contours; c++) {
+            u32 end = std::min(u16At(endPoints + c * 2) + 1, pointCount);
+            if (end > start) contour(outline, points.ptr + start, end - start);
+            start = end;
+        }
+    }
+
+    void appendGlyph(
+        Font const& font,
+        u32 glyph,
+        Transform const& transform,
+        Outline* outline,
+        u32 depth
+    ) {
+        u8 const* end;
+        u8 const* data = glyphData(font, glyph, &end);
+        if (data == nullptr || depth > 8) return;
+
+        i32 contours = i16At(data);
+        if (contours > 0) {
+            simpleGlyph(data, end, contours, transform, outline);
+            return;
+        }
+
+        // Compound, components placed by offset and an optional 2x2.
+        // Records running past `end` are dropped.
+        u8 const* p = data + 10;
+        for (;;) {
+            if (p + 4 > end) return;
+
+            u32 flags = u16At(p);
+            u32 component = u16At(p + 2);
+            p += 4;
+
+            u32 argumentBytes = (flags & 1) ? 4 : 2;
+            u32 scaleBytes = (flags & 8) ? 2 : (flags & 0x40) ? 4 : (flags & 0x80) ? 8 : 0;
+            if (p + argumentBytes + scaleBytes > end) return;
+
+            f32 dx, dy;
+            if (flags & 1) {
+                dx = i16At(p);
+                dy = i16At(p + 2);
+                p += 4;
+            } else {
+                dx = (signed char)p[0];
+                dy = (signed char)p[1];
+                p += 2;
+            }
+
+            // Point matching (no ARGS_ARE_XY_VALUES) is not supported.
+            if (!(flags & 2)) dx = dy = 0.0f;
+
+            Transform local {1.0f, 0.0f, 0.0f, 1.0f, dx, dy};
+            if (flags & 8) {
+                local.a = local.d = f2dot14At(p);
+                p += 2;
+            } else if (flags & 0x40) {
+                local.a = f2dot14At(p);
+                local.d = f2dot14At(p + 2);
+                p += 4;
+            } else if (flags & 0x80) {
+                local.a = f2dot14At(p);
+                local.b = f2dot14At(p + 2);
+                local.c = f2dot14At(p + 4);
+                local.d = f2dot14At(p + 6);
+                p += 8;
+            }
+
+            Transform combined {
+                transform.a * local.a + transform.c * local.b,
+                transform.b * local.a + transform.d * local.b,
+                transform.a * local.c + transform.c * local.d,
+                transform.b * local.c + transform.d * local.d,
+                transform.a * local.e + transform.c * local.f + transform.e,
+                transform.b * local.e + transform.d * local.f + transform.f,
+            };
+
+            appendGlyph(font, component, combined, outline, depth + 1);
+            if (!(flags & 0x20)) break;
+        }
+    }
+
+    u32 outline(Font const& font, u32 glyph, std::Slice<Segment> segments) {
+        Outline result {segments, 0};
+        appendGlyph(font, glyph, {1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f}, &result, 0);
+        return result.count;
+    }
+}
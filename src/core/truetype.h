@@ -0,0 +1,56 @@
+#pragma once
+#include <std/slice.h>
+
+// Minimal TrueType (glyf outlines) reader for the text module: cmap
+// formats 4 and 12, horizontal metrics and simple/compound glyphs
+// flattened to line segments. No hinting, kerning or OpenType layout.
+namespace igfx::truetype {
+    struct Segment {
+        f32 x0, y0;
+        f32 x1, y1;
+    };
+
+    struct Font {
+        std::Buf<u8> data;
+
+        u32 glyf;
+        u32 glyfLength;
+        u32 loca;
+        u32 hmtx;
+        u32 cmap; // subtable offset
+        u32 cmapEnd; // end of the cmap table, bounds the subtable
+        u32 cmapFormat;
+
+        u32 unitsPerEm;
+        u32 glyphCount;
+        u32 hMetricCount;
+        bool longLoca;
+
+        i32 ascent;
+        i32 descent; // negative, below the baseline
+        i32 lineGap;
+    };
+
+    struct GlyphBox {
+        i32 xMin, yMin;
+        i32 xMax, yMax;
+    };
+
+    // False (with a warning) when `path` is not a TrueType font with glyf
+    // outlines or its tables are too short for their counts. Glyph data is
+    // checked as it's read, malformed glyphs have no outline.
+    bool load(Font* font, u8 const* path);
+    void unload(Font* font);
+
+    // 0 (.notdef) for unmapped codepoints.
+    u32 glyphIndex(Font const& font, u32 codepoint);
+    u32 advance(Font const& font, u32 glyph);
+
+    // False for glyphs without an outline (e.g. space).
+    bool box(Font const& font, u32 glyph, GlyphBox* box);
+
+    // Appends the glyph's contours as segments in font units (y up),
+    // quadratic curves split into straight pieces. Returns the count
+    // written, at most `segments.len`.
+    u32 outline(Font const& font, u32 glyph, std::Slice<Segment> segments);
+}
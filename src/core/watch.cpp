@@ -0,0 +1,131 @@
+#include "core/watch.h"
+#include "core/timer.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#if __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#elif _WIN32
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#endif
+
+namespace igfx::watch {
+    // Splits `path` into the directory (written to `dir`) and file name.
+    u8 const* splitPath(u8 const* path, u8* dir, usize dirSize) {
+        u8 const* name = path;
+        for (u8 const* c = path; *c != '\0'; c++) {
+            if (*c == '/' || *c == '\\') name = c + 1;
+        }
+
+        usize dirLen = (usize)(name - path);
+        if (dirLen == 0) {
+            snprintf(dir, dirSize, ".");
+        } else {
+            snprintf(dir, dirSize, "%.*s", (int)dirLen, path);
+        }
+
+        return name;
+    }
+
+#if __linux__
+    bool Watch::init(u8 const* filePath) {
+        snprintf(path, sizeof(path), "%s", filePath);
+
+        u8 dir[512];
+        snprintf(name, sizeof(name), "%s", splitPath(filePath, dir, sizeof(dir)));
+
+        changedAt = 0.0;
+        fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (fd < 0) {
+            std::warn("failed to initialize inotify, '{}' won't be watched", filePath);
+            return false;
+        }
+
+        wd = inotify_add_watch(fd, dir, IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+        if (wd < 0) {
+            std::warn("failed to watch '{}'", dir);
+            close(fd);
+            fd = -1;
+            return false;
+        }
+
+        return true;
+    }
+
+    void Watch::deinit() {
+        if (fd < 0) return;
+
+        inotify_rm_watch(fd, wd);
+        close(fd);
+        fd = -1;
+    }
+
+    bool Watch::changed() {
+        if (fd < 0) return false;
+
+        alignas(inotify_event) u8 events[4096];
+        for (;;) {
+            ssize_t len = read(fd, events, sizeof(events));
+            if (len <= 0) break;
+
+            for (ssize_t offset = 0; offset < len;) {
+                inotify_event const* event = (inotify_event const*)(events + offset);
+                if (event->len > 0 && strcmp(event->name, name) == 0) changedAt = timer::now();
+
+                offset += (ssize_t)(sizeof(inotify_event) + event->len);
+            }
+        }
+
+        if (changedAt == 0.0 || timer::now() - changedAt < settleTime) return false;
+
+        changedAt = 0.0;
+        return true;
+    }
+#else
+    u64 lastWriteTime(u8 const* path) {
+#if _WIN32
+        WIN32_FILE_ATTRIBUTE_DATA data;
+        if (!GetFileAttributesExA(path, GetFileExInfoStandard, &data)) return 0;
+
+        return ((u64)data.ftLastWriteTime.dwHighDateTime << 32) | data.ftLastWriteTime.dwLowDateTime;
+#else
+        struct stat info;
+        if (stat(path, &info) != 0) return 0;
+
+        return (u64)info.st_mtime;
+#endif
+    }
+
+    bool Watch::init(u8 const* filePath) {
+        snprintf(path, sizeof(path), "%s", filePath);
+
+        u8 dir[512];
+        snprintf(name, sizeof(name), "%s", splitPath(filePath, dir, sizeof(dir)));
+
+        fd = -1;
+        wd = -1;
+        changedAt = 0.0;
+        lastWrite = lastWriteTime(path);
+        return true;
+    }
+
+    void Watch::deinit() {}
+
+    bool Watch::changed() {
+        u64 write = lastWriteTime(path);
+        if (write != 0 && write != lastWrite) {
+            lastWrite = write;
+            changedAt = timer::now();
+        }
+
+        if (changedAt == 0.0 || timer::now() - changedAt < settleTime) return false;
+
+        changedAt = 0.0;
+        return true;
+    }
+#endif
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+// Reports when a file was rewritten, polled from a frame loop. Linux uses
+// inotify on the parent directory (linkers and installers replace files
+// by renaming a new inode over the old path), other platforms compare
+// modification times.
+namespace igfx::watch {
+    struct Watch {
+        // Changes closer together than this are reported once, after the
+        // last one, so a file still being written is never picked up.
+        static constexpr f64 settleTime = 0.2; // seconds
+
+        u8 name[256]; // file name within the watched directory
+        u8 path[512];
+        i32 fd;
+        i32 wd;
+        u64 lastWrite; // polling fallback
+        f64 changedAt; // 0 when nothing is pending
+
+        // False (with a warning) when the file can't be watched.
+        bool init(u8 const* path);
+        void deinit();
+
+        // Never blocks, true once per settled change.
+        bool changed();
+    };
+}
@@ -4,17 +4,23 @@
 namespace igfx::window {
     Window window;
 
-    void init() {
-        if (!glfwInit()) std::fatal("failed to initialize glfw");
+    bool initPlatform() {
+        if (!glfwInit()) return false;
+
         glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+        return true;
+    }
+
+    void onFramebufferSize(GLFWwindow*, i32, i32) {
+        window.resized = true;
+    }
 
-        const u32 windowWidth = 640; 
-        const u32 windowHeight = 480; 
+    void init(u32 width, u32 height, u8 const* title) {
 
         GLFWwindow* windowPtr = glfwCreateWindow(
-            windowWidth, 
-            windowHeight, 
-            "", 
+            width, 
+            height, 
+            title, 
             nullptr, 
             nullptr
         );
@@ -24,33 +30,65 @@ namespace igfx::window {
             std::fatal("failed to create a window");
         }
 
+        i32 framebufferWidth, framebufferHeight;
+        glfwGetFramebufferSize(windowPtr, &framebufferWidth, &framebufferHeight);
+        glfwSetFramebufferSizeCallback(windowPtr, onFramebufferSize);
+
         window = {
             .ptr = windowPtr,
-            .width = windowWidth,
-            .height = windowHeight,
+            .width = width,
+            .height = height,
+            .framebufferWidth = (u32)framebufferWidth,
+            .framebufferHeight = (u32)framebufferHeight,
+            .frameWidth = width,
+            .frameHeight = height,
+        };
+    }
+
+    void initHeadless(u32 width, u32 height) {
+        window = {
+            .ptr = nullptr,
+            .width = width,
+            .height = height,
+            .framebufferWidth = width,
+            .framebufferHeight = height,
+            .frameWidth = width,
+            .frameHeight = height,
         };
     }
 
     void deinit() {
+        if (window.ptr == nullptr) return;
+
         glfwDestroyWindow(window.ptr);
+        glfwTerminate();
+        window.ptr = nullptr;
     }
 
     u32 width() {
-        return window.width;
+        return window.frameWidth;
     }
 
     u32 height() {
-        return window.height;
+        return window.frameHeight;
     }
 
     vec2 size() {
         return {
-            static_cast<f32>(window.width), 
-            static_cast<f32>(window.height), 
+            static_cast<f32>(window.frameWidth), 
+            static_cast<f32>(window.frameHeight), 
         };
     }
 
+    // May be called from the simulation thread (Config::pipelined).
+    void close() {
+        __atomic_store_n(&window.closeRequested, true, __ATOMIC_RELEASE);
+    }
+
     bool shouldClose() {
+        bool closeRequested = __atomic_load_n(&window.closeRequested, __ATOMIC_ACQUIRE);
+        if (window.ptr == nullptr) return closeRequested;
+
         glfwSwapBuffers(window.ptr);
         glfwPollEvents();
 
@@ -60,7 +98,13 @@ namespace igfx::window {
         window.width = windowWidth;
         window.height = windowHeight;
 
-        return glfwWindowShouldClose(window.ptr);
+        i32 framebufferWidth, framebufferHeight;
+        glfwGetFramebufferSize(window.ptr, &framebufferWidth, &framebufferHeight);
+
+        window.framebufferWidth = framebufferWidth;
+        window.framebufferHeight = framebufferHeight;
+
+        return closeRequested || glfwWindowShouldClose(window.ptr);
     }
 
     VkSurfaceKHR createSurface(VkInstance instance) {
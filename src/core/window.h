@@ -5,13 +5,28 @@
 namespace igfx::window {
     struct Window {
         GLFWwindow* ptr;
-        u32 width;
+        u32 width; // screen coordinates
         u32 height;
+        // Pixels, differs from the size on HiDPI displays.
+        u32 framebufferWidth;
+        u32 framebufferHeight;
+        bool resized; // since the swapchain was last created
+        // The size seen by the frame being recorded, set by
+        // `engine::beginFrame` on the thread running the user code. The
+        // fields above belong to the main thread.
+        u32 frameWidth;
+        u32 frameHeight;
+        bool closeRequested;
     };
 
     extern Window window;
 
-    void init();
+    // Connects to the display, false when there is none. Must precede
+    // `init` and Vulkan instance creation.
+    bool initPlatform();
+    void init(u32 width, u32 height, u8 const* title);
+    // No window is created, the size only describes the render target.
+    void initHeadless(u32 width, u32 height);
     void deinit();
 
     VkSurfaceKHR createSurface(VkInstance);
@@ -1,14 +1,258 @@
+#include "engine.h"
 #include "core/graphics.h"
+#include "core/software.h"
+#include "core/sprites.h"
+#include "core/textures.h"
+#include "core/text.h"
+#include "core/capture.h"
+#include "core/timer.h"
+#include "core/jobs.h"
+#include "core/thread.h"
 #include "core/window.h"
+#include "core/startup.h"
+
+#include <std/mem.h>
+#include <std/math.h>
+#include <stdlib.h>
 
 namespace igfx::engine {
-    void init() {
-        window::init();
-        graphics::init();
+    Backend backend;
+
+    struct FrameSlot {
+        Frame frame;
+        f32 deltaTime;
+        f64 start;
+        f32 userTime;
+        u32 windowWidth; // as of `beginFrame`
+        u32 windowHeight;
+    };
+
+    // Slots are used round robin, `produced - consumed` counts the ones
+    // being recorded, waiting or rendering.
+    struct Frames {
+        FrameSlot slots[graphics::maxFrameSlots];
+        u32 depth;
+        u64 produced;
+        u64 consumed;
+        bool stopped;
+        // Published by `render` on the main thread, which polls the window.
+        u32 windowWidth;
+        u32 windowHeight;
+
+        thread::Mutex mutex;
+        thread::Condition changed;
+    };
+
+    Frames frames;
+
+    // IGFX_BACKEND=vulkan|software overrides the configured backend.
+    inline Backend requestedBackend(Backend requested) {
+        u8 const* env = getenv("IGFX_BACKEND");
+        if (env != nullptr) {
+            if (std::eqlZ(env, "vulkan")) return Backend::Vulkan;
+            if (std::eqlZ(env, "software")) return Backend::Software;
+            std::warn("unknown IGFX_BACKEND '{}'", env);
+        }
+
+        return requested;
+    }
+
+    void initInstanceJob(u32, void* found) {
+        u32 phase = startup::phase("vulkan instance + device selection");
+        *(bool*)found = graphics::initInstance();
+        startup::end(phase);
+    }
+
+    // Instance creation and scoring every GPU take as long as creating the
+    // window, so they run on a job thread meanwhile. False when no device
+    // is suitable, the window is destroyed again.
+    bool initVulkan(Config const& config) {
+        u32 phase = startup::phase("glfw");
+        bool platform = window::initPlatform();
+        startup::end(phase);
+
+        if (!platform) {
+            std::warn("failed to initialize glfw (no display?)");
+            return false;
+        }
+
+        bool found = false;
+        jobs::Counter counter;
+        jobs::submit(initInstanceJob, &found, 1, &counter);
+
+        phase = startup::phase("window");
+        window::init(config.width, config.height, config.title);
+        startup::end(phase);
+
+        jobs::wait(&counter);
+        if (!found) {
+            window::deinit();
+            return false;
+        }
+
+        graphics::init(config);
+        return true;
+    }
+
+    void init(Config config) {
+        startup::begin();
+
+        u32 phase = startup::phase("jobs + text");
+        jobs::init();
+        graphics::initText();
+        startup::end(phase);
+
+        backend = requestedBackend(config.backend);
+        if (backend != Backend::Software) {
+            if (initVulkan(config)) {
+                backend = Backend::Vulkan;
+            } else if (backend == Backend::Vulkan) {
+                std::fatal("failed to find a suitable GPU");
+            } else {
+                std::warn("no suitable GPU found, using the software backend");
+                backend = Backend::Software;
+            }
+        }
+
+        if (backend == Backend::Software) {
+            phase = startup::phase("software backend");
+            window::initHeadless(config.width, config.height);
+            software::init(config.width, config.height);
+            startup::end(phase);
+        }
+
+        u8 const* capturePath = getenv("IGFX_CAPTURE");
+        if (capturePath == nullptr) capturePath = config.capturePath;
+        if (capturePath != nullptr) capture::begin(capturePath, config.width, config.height);
+
+        frames.depth = config.pipelined ? std::clamp(config.pipelineDepth, 2u, graphics::maxFrameSlots) : 1;
+        frames.produced = 0;
+        frames.consumed = 0;
+        frames.stopped = false;
+        frames.windowWidth = window::window.width;
+        frames.windowHeight = window::window.height;
+        frames.mutex.init();
+        frames.changed.init();
+
+        for (u32 i = 0; i < graphics::maxFrameSlots; i++) frames.slots[i].frame.index = i;
     }
 
     void deinit() {
+        capture::end();
+
+        frames.changed.deinit();
+        frames.mutex.deinit();
+
+        switch (backend) {
+        case Backend::Software:
+            software::deinit();
+            break;
+        default:
+            graphics::deinit();
+            break;
+        }
+
+        graphics::deinitText();
+        graphics::destroyTextures();
         window::deinit();
-        graphics::deinit();
+        jobs::deinit();
+    }
+
+    Frame* beginFrame(f32 deltaTime) {
+        frames.mutex.lock();
+        while (frames.produced - frames.consumed >= frames.depth && !frames.stopped) {
+            frames.changed.wait(&frames.mutex);
+        }
+
+        if (frames.stopped) {
+            frames.mutex.unlock();
+            return nullptr;
+        }
+
+        FrameSlot& slot = frames.slots[frames.produced % frames.depth];
+        slot.windowWidth = frames.windowWidth;
+        slot.windowHeight = frames.windowHeight;
+        frames.mutex.unlock();
+
+        window::window.frameWidth = slot.windowWidth;
+        window::window.frameHeight = slot.windowHeight;
+
+        graphics::spriteLists[slot.frame.index].clear();
+        graphics::beginTextFrame();
+        slot.deltaTime = deltaTime;
+        slot.start = timer::now();
+        return &slot.frame;
+    }
+
+    void endFrame(Frame* frame) {
+        FrameSlot& slot = frames.slots[frame->index];
+        slot.userTime = (f32)(timer::now() - slot.start);
+
+        frames.mutex.lock();
+        frames.produced++;
+        frames.changed.broadcast();
+        frames.mutex.unlock();
+    }
+
+    bool render() {
+        frames.mutex.lock();
+        frames.windowWidth = window::window.width;
+        frames.windowHeight = window::window.height;
+        while (frames.consumed == frames.produced && !frames.stopped) {
+            frames.changed.wait(&frames.mutex);
+        }
+
+        if (frames.consumed == frames.produced) {
+            frames.mutex.unlock();
+            return false;
+        }
+
+        FrameSlot& slot = frames.slots[frames.consumed % frames.depth];
+        frames.mutex.unlock();
+
+        // Textures loaded by `init` are read on job threads, the first frame
+        // waits for them rather than drawing them white.
+        bool first = frames.consumed == 0;
+        if (first) {
+            u32 phase = startup::phase("texture loads");
+            graphics::waitForTextureLoads();
+            startup::end(phase);
+        }
+
+        auto sprites = graphics::spriteLists[slot.frame.index].slice();
+        if (capture::active()) capture::frame(slot.deltaTime, slot.userTime, sprites);
+
+        switch (backend) {
+        case Backend::Software:
+            software::render(sprites);
+            break;
+        default:
+            graphics::render(sprites);
+            break;
+        }
+
+        if (first) startup::finish();
+
+        frames.mutex.lock();
+        frames.consumed++;
+        frames.changed.broadcast();
+        frames.mutex.unlock();
+
+        return true;
+    }
+
+    void drain() {
+        frames.mutex.lock();
+        while (frames.consumed != frames.produced && !frames.stopped) {
+            frames.changed.wait(&frames.mutex);
+        }
+        frames.mutex.unlock();
+    }
+
+    void stop() {
+        frames.mutex.lock();
+        frames.stopped = true;
+        frames.changed.broadcast();
+        frames.mutex.unlock();
     }
 }
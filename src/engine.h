@@ -1,4 +1,27 @@
+#include "igfx/config.h"
+#include "igfx/graphics.h"
+
 namespace igfx::engine {
-    void init();
+    void init(Config config);
     void deinit();
+
+    // Frames are recorded into slots handed from the thread running the
+    // user code to the render thread, with `Config::pipelined` these are
+    // different threads, otherwise the calls simply alternate.
+
+    // Blocks until a slot is free, nullptr once `stop` was called.
+    Frame* beginFrame(f32 deltaTime);
+    void endFrame(Frame*);
+
+    // Renders the oldest recorded frame, blocks until one is available,
+    // false once `stop` was called and no frames are left.
+    bool render();
+
+    // Blocks until every recorded frame was rendered. Until the next
+    // `beginFrame` the render thread then touches no engine state, so the
+    // user code may register assets (`init` after a hot reload).
+    void drain();
+
+    // Wakes both threads for shutdown.
+    void stop();
 }
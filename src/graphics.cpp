@@ -1,8 +1,137 @@
 #include "igfx/graphics.h"
 #include "core/graphics.h"
+#include "core/software.h"
+#include "core/sprites.h"
+#include "core/textures.h"
+#include "core/text.h"
+#include "core/startup.h"
 
 namespace igfx {
+    namespace graphics {
+        SpriteList spriteLists[maxFrameSlots];
+
+        SpriteTable spriteTable = {
+            .entries = {{
+                .width = 1,
+                .height = 1,
+                .uv = {0, 0, 0xffff, 0xffff},
+                .tint = 0xffffffff,
+                .texture = 0,
+            }},
+            .count = 1,
+            .dirty = true,
+        };
+
+        // Sprites and fonts by the path they were loaded from. A hot reload
+        // that runs `init` again gets the same handles back instead of
+        // loading every asset twice.
+        struct LoadedAsset {
+            std::Buf<u8> path;
+            u32 index;
+            bool font;
+        };
+
+        constexpr u32 maxLoadedAssets = SpriteTable::capacity + Text::maxFonts;
+        LoadedAsset loadedAssets[maxLoadedAssets];
+        u32 loadedAssetCount;
+
+        LoadedAsset const* findLoaded(u8 const* path, bool font) {
+            for (u32 i = 0; i < loadedAssetCount; i++) {
+                LoadedAsset const& asset = loadedAssets[i];
+                if (asset.font == font && std::eqlZ(asset.path.ptr, path)) return &asset;
+            }
+
+            return nullptr;
+        }
+
+        void addLoaded(u8 const* path, u32 index, bool font) {
+            if (loadedAssetCount == maxLoadedAssets) return;
+
+            usize length = __builtin_strlen(path) + 1;
+            std::Buf<u8> copy = std::alloc<u8>(length);
+            __builtin_memcpy(copy.ptr, path, length);
+
+            loadedAssets[loadedAssetCount++] = {.path = copy, .index = index, .font = font};
+        }
+    }
+
     void Frame::DrawSprite(Sprite sprite, DrawSpriteOptions options) {
+        graphics::spriteLists[index].push({
+            .sprite = sprite.index,
+            .position = options.position,
+            .scale = options.scale,
+            .rotation = options.rotation,
+            .blend = options.blend,
+            .color = 0xffffffff,
+        });
+    }
+
+    void Frame::DrawText(Font font, u8 const* text, DrawTextOptions options) {
+        graphics::drawText(&graphics::spriteLists[index], font.index, text, options);
+    }
+
+    Sprite addSprite(u32 width, u32 height, u32 texture) {
+        graphics::SpriteTable& table = graphics::spriteTable;
+        if (table.count == graphics::SpriteTable::capacity) {
+            std::fatal("sprite limit ({}) reached", graphics::SpriteTable::capacity);
+        }
+
+        table.entries[table.count] = {
+            .width = width,
+            .height = height,
+            .uv = {0, 0, 0xffff, 0xffff},
+            .tint = 0xffffffff,
+            .texture = texture,
+        };
+        table.dirty = true;
+
+        return {table.count++};
+    }
+
+    Sprite createSprite(Image image) {
+        return addSprite(image.width, image.height, graphics::createTexture(image));
+    }
+
+    Font loadFont(u8 const* path) {
+        if (graphics::LoadedAsset const* loaded = graphics::findLoaded(path, true)) return {loaded->index};
+
+        u32 font = graphics::loadFont(path);
+        if (font != 0) graphics::addLoaded(path, font, true);
+        return {font};
+    }
+
+    vec2 measureText(Font font, u8 const* text, f32 size) {
+        return graphics::measureText(font.index, text, size);
+    }
+
+    Sprite loadSprite(u8 const* path) {
+        if (graphics::LoadedAsset const* loaded = graphics::findLoaded(path, false)) return {loaded->index};
+
+        u32 width, height;
+        u32 texture = graphics::loadTexture(path, &width, &height);
+        Sprite sprite = addSprite(width, height, texture);
+        graphics::addLoaded(path, sprite.index, false);
+        return sprite;
+    }
+
+    TextureStats textureStats() {
+        return graphics::textures.stats;
+    }
+
+    f32 renderScale() {
+        graphics::DynamicResolution const& resolution = graphics::graphics.resolution;
+        return resolution.enabled ? resolution.scale : 1.0f;
+    }
+
+    StartupReport const& startupReport() {
+        return startup::startup.report;
+    }
 
+    Image framebuffer() {
+        return {
+            .width = software::framebuffer.width,
+            .height = software::framebuffer.height,
+            .pixels = software::framebuffer.pixels.ptr,
+        };
     }
 }
@@ -1,6 +1,9 @@
 #include "engine.h"
 #include "window.h"
 #include "igfx/graphics.h"
+#include "igfx/config.h"
+#include "core/thread.h"
+#include "core/startup.h"
 
 #if _WIN32
 #include <windows.h>
@@ -17,77 +20,249 @@ using DLLHandle = void*;
 #endif
 
 #ifdef USER_DLL
+#include "core/watch.h"
+
+#include <stdio.h>
+
+using ConfigureFn = void(*)(igfx::Config*);
 using InitFn = void(*)();
 using UpdateFn = void(*)(f32);
 using DrawFn = void(*)(igfx::Frame*);
+using UnloadFn = void*(*)();
+using ReloadFn = void(*)(void*);
+
+// The library is loaded from a versioned copy (`libuser-<n>.so`) so the
+// build can overwrite USER_DLL while it runs (Windows locks loaded DLLs)
+// and so the loader can't hand back a cached older image for the same
+// path. When the watch reports a rebuild the functions are swapped between
+// frames, on the thread running the user code, the engine and everything
+// it holds on the GPU stay alive.
 struct {
-    DLLHandle handle = nullptr;
-    struct {
+    struct Fns {
+        ConfigureFn configure; // optional
         InitFn init;
         UpdateFn update;
         DrawFn draw;
-    } fns;
+        // Optional, `unload` returns state handed to the next version's
+        // `reload`, which then runs instead of `init`.
+        UnloadFn unload;
+        ReloadFn reload;
+    };
+
+    DLLHandle handle = nullptr;
+    Fns fns;
+    u32 version = 0;
+    u8 loadedPath[512];
+    igfx::watch::Watch watch;
+    bool watching = false;
+
+    void versionedPath(u32 n, u8* path, usize size) {
+        u8 const* extension = nullptr;
+        for (u8 const* c = USER_DLL; *c != '\0'; c++) {
+            if (*c == '.') extension = c;
+            if (*c == '/' || *c == '\\') extension = nullptr;
+        }
 
-    void reload() {
-        if (handle != nullptr) {
-            CLOSE_DLL(handle);
+        if (extension == nullptr) {
+            snprintf(path, size, "%s-%u", USER_DLL, n);
+        } else {
+            snprintf(path, size, "%.*s-%u%s", (int)(extension - USER_DLL), USER_DLL, n, extension);
         }
+    }
+
+    bool copyFile(u8 const* from, u8 const* to) {
+        FILE* src = fopen(from, "rb");
+        if (src == nullptr) return false;
+        defer { fclose(src); };
+
+        FILE* dst = fopen(to, "wb");
+        if (dst == nullptr) return false;
+
+        u8 buffer[64 * 1024];
+        bool ok = true;
+        for (;;) {
+            usize read = fread(buffer, 1, sizeof(buffer), src);
+            if (read == 0) break;
+            if (fwrite(buffer, 1, read, dst) != read) {
+                ok = false;
+                break;
+            }
+        }
+
+        if (ferror(src)) ok = false;
+        if (fclose(dst) != 0) ok = false;
+        return ok;
+    }
 
-        handle = LOAD_DLL(USER_DLL);
+    // Loads version `n`, warns and returns nullptr on failure.
+    DLLHandle open(u32 n, Fns* out, u8* path, usize size) {
+        versionedPath(n, path, size);
+        if (!copyFile(USER_DLL, path)) {
+            std::warn("failed to copy '{}' to '{}'", USER_DLL, path);
+            return nullptr;
+        }
+
+        DLLHandle loaded = LOAD_DLL(path);
+        if (loaded == nullptr) {
+            std::warn("failed to load dynamic library '{}'", path);
+            remove(path);
+            return nullptr;
+        }
+
+        Fns fns {
+            .configure = (ConfigureFn)GET_SYM(loaded, "configure"),
+            .init = (InitFn)GET_SYM(loaded, "init"),
+            .update = (UpdateFn)GET_SYM(loaded, "update"),
+            .draw = (DrawFn)GET_SYM(loaded, "draw"),
+            .unload = (UnloadFn)GET_SYM(loaded, "unload"),
+            .reload = (ReloadFn)GET_SYM(loaded, "reload"),
+        };
+
+        u8 const* missing = fns.init == nullptr ? "init"
+            : fns.update == nullptr ? "update"
+            : fns.draw == nullptr ? "draw"
+            : nullptr;
+
+        if (missing != nullptr) {
+            std::warn("failed to load function '{}' from '{}'", missing, path);
+            CLOSE_DLL(loaded);
+            remove(path);
+            return nullptr;
+        }
+
+        *out = fns;
+        return loaded;
+    }
+
+    void load() {
+        handle = open(version, &fns, loadedPath, sizeof(loadedPath));
         if (handle == nullptr) {
             std::fatal("error: failed to load dynamic library '{}'", USER_DLL);
         }
 
-        fns.init = loadFn<InitFn>("init");
-        fns.update = loadFn<UpdateFn>("update");
-        fns.draw = loadFn<DrawFn>("draw");
+        watching = watch.init(USER_DLL);
     }
 
-    template<typename Fn>
-    Fn loadFn(const u8 name[]) {
-        Fn fn = (Fn)GET_SYM(handle, name);
-        if (fn == nullptr) {
-            std::fatal("error: failed to load function '{}'", name);
+    // Swaps in a rebuilt library, must be called between frames from the
+    // thread running the user code. A broken build keeps the current one.
+    // In pipelined mode the render thread is drained first, `init` creates
+    // sprites and fonts it would otherwise read concurrently.
+    void poll() {
+        if (!watching || !watch.changed()) return;
+
+        Fns next;
+        u8 nextPath[512];
+        DLLHandle nextHandle = open(version + 1, &next, nextPath, sizeof(nextPath));
+        if (nextHandle == nullptr) return;
+
+        igfx::engine::drain();
+
+        void* state = fns.unload != nullptr ? fns.unload() : nullptr;
+
+        CLOSE_DLL(handle);
+        remove(loadedPath);
+
+        handle = nextHandle;
+        fns = next;
+        version++;
+        __builtin_memcpy(loadedPath, nextPath, sizeof(loadedPath));
+
+        if (fns.reload != nullptr) {
+            fns.reload(state);
+        } else {
+            fns.init();
         }
 
-        return fn; 
+        std::debug("reloaded '{}' (version {})", USER_DLL, version);
+    }
+
+    void unload() {
+        if (watching) watch.deinit();
+
+        CLOSE_DLL(handle);
+        remove(loadedPath);
     }
 } user;
 
 #else
+extern "C" [[gnu::weak]] void configure(igfx::Config*);
 extern "C" void init();
 extern "C" void update(f32);
 extern "C" void draw(igfx::Frame*);
 #endif
 
-int main() {
-    igfx::engine::init();
-    defer { igfx::engine::deinit(); };
-
+void step(igfx::Frame* frame, f32 deltaTime) {
 #ifdef USER_DLL
-    user.reload();
-    user.fns.init();
+    user.fns.update(deltaTime);
+    user.fns.draw(frame);
 #else
-    init();
+    update(deltaTime);
+    draw(frame);
 #endif
+}
 
-    while (!igfx::window::shouldClose()) {
+// Simulation thread of the pipelined mode, records frames ahead of the
+// render (main) thread until the engine stops.
+void simulate(void*) {
+    for (;;) {
         f32 deltaTime = 1.0f;
+
 #ifdef USER_DLL
-        user.fns.update(deltaTime);
+        user.poll();
+#endif
+
+        igfx::Frame* frame = igfx::engine::beginFrame(deltaTime);
+        if (frame == nullptr) return;
+
+        step(frame, deltaTime);
+        igfx::engine::endFrame(frame);
+    }
+}
+
+int main() {
+    igfx::Config config;
+#ifdef USER_DLL
+    user.load();
+    if (user.fns.configure != nullptr) user.fns.configure(&config);
 #else
-        update(deltaTime);
+    if (configure != nullptr) configure(&config);
 #endif
 
-        igfx::Frame frame;
+    igfx::engine::init(config);
+    defer { igfx::engine::deinit(); };
+
+    u32 phase = igfx::startup::phase("user init");
 #ifdef USER_DLL
-        user.fns.draw(&frame);
+    user.fns.init();
 #else
-        draw(&frame);
+    init();
 #endif
+    igfx::startup::end(phase);
+
+    if (config.pipelined) {
+        igfx::thread::Thread simulation = igfx::thread::spawn(simulate, nullptr);
+
+        while (!igfx::window::shouldClose() && igfx::engine::render());
+
+        igfx::engine::stop();
+        igfx::thread::join(simulation);
+    } else {
+        while (!igfx::window::shouldClose()) {
+            f32 deltaTime = 1.0f;
+
+#ifdef USER_DLL
+            user.poll();
+#endif
+
+            igfx::Frame* frame = igfx::engine::beginFrame(deltaTime);
+            step(frame, deltaTime);
+            igfx::engine::endFrame(frame);
+
+            igfx::engine::render();
+        }
     }
 
 #ifdef USER_DLL
-    CLOSE_DLL(user.handle);
+    user.unload();
 #endif
 }
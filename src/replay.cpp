@@ -0,0 +1,226 @@
+#include "engine.h"
+#include "window.h"
+#include "core/capture.h"
+#include "core/sprites.h"
+#include "core/textures.h"
+#include "core/text.h"
+#include "core/timer.h"
+
+#include <std/alloc.h>
+#include <std/math.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace igfx;
+
+// Render times are bucketed at 10us up to 200ms for percentiles.
+struct Histogram {
+    static constexpr u32 bucketCount = 20000;
+    static constexpr f64 bucketSeconds = 1e-5;
+
+    u32 buckets[bucketCount];
+    u32 count;
+    f64 sum;
+    f64 max;
+    u32 maxFrame;
+
+    void add(u32 frame, f64 seconds) {
+        u32 bucket = (u32)(seconds / bucketSeconds);
+        buckets[bucket < bucketCount ? bucket : bucketCount - 1]++;
+
+        count++;
+        sum += seconds;
+        if (seconds > max) {
+            max = seconds;
+            maxFrame = frame;
+        }
+    }
+
+    f64 percentile(f64 p) const {
+        u32 target = (u32)(p * count);
+        u32 seen = 0;
+        for (u32 i = 0; i < bucketCount; i++) {
+            seen += buckets[i];
+            if (seen > target) return (i + 1) * bucketSeconds;
+        }
+
+        return max;
+    }
+};
+
+Histogram userTimes;
+Histogram renderTimes;
+
+// Captured texture indices to the ones created here, 0 is the default.
+u32 textureMap[graphics::Textures::capacity];
+u32 textureCount = 1;
+
+// Recreates the textures and sprite table entries added before `record`'s
+// frame, so its commands draw what they drew when captured.
+void rebuild(FILE* file, capture::FrameRecord const& record) {
+    for (u32 i = 0; i < record.textureCount; i++) {
+        capture::TextureRecord texture;
+        if (fread(&texture, sizeof(texture), 1, file) != 1) {
+            std::fatal("capture truncated at frame {}", record.index);
+        }
+        if (textureCount == graphics::Textures::capacity) {
+            std::fatal("frame {} has too many textures", record.index);
+        }
+
+        auto payload = std::alloc<u8>(std::max(texture.bytes, 1u));
+        defer { std::free(payload); };
+        if (fread(payload.ptr, 1, texture.bytes, file) != texture.bytes) {
+            std::fatal("capture truncated at frame {}", record.index);
+        }
+
+        u32 index = 0;
+        switch (texture.source) {
+        case capture::TextureSource::Path: {
+            payload[texture.bytes - 1] = '\0';
+            u32 width, height;
+            index = graphics::loadTexture(payload.ptr, &width, &height);
+            break;
+        }
+        case capture::TextureSource::Pixels:
+            if (texture.bytes != texture.width * texture.height * sizeof(u32)) {
+                std::fatal("frame {} has a malformed texture", record.index);
+            }
+            index = graphics::createTexture({
+                .width = texture.width,
+                .height = texture.height,
+                .pixels = (u32 const*)payload.ptr,
+            });
+            break;
+        case capture::TextureSource::Atlas:
+            index = graphics::addExternalTexture(graphics::text.set);
+            break;
+        default:
+            std::fatal("frame {} has a malformed texture", record.index);
+        }
+
+        textureMap[textureCount++] = index;
+    }
+
+    graphics::SpriteTable& table = graphics::spriteTable;
+    if (table.count + record.spriteInfoCount > graphics::SpriteTable::capacity) {
+        std::fatal("frame {} has too many sprites", record.index);
+    }
+
+    for (u32 i = 0; i < record.spriteInfoCount; i++) {
+        graphics::SpriteInfo info;
+        if (fread(&info, sizeof(info), 1, file) != 1) {
+            std::fatal("capture truncated at frame {}", record.index);
+        }
+
+        info.texture = info.texture < textureCount ? textureMap[info.texture] : 0;
+        table.entries[table.count++] = info;
+        table.dirty = true;
+    }
+}
+
+void report(u8 const* name, Histogram const& histogram) {
+    if (histogram.count == 0) return;
+
+    printf(
+        "%-8s mean %7.3f ms  p50 %7.3f ms  p99 %7.3f ms  max %7.3f ms (frame %u)\n",
+        name,
+        histogram.sum / histogram.count * 1e3,
+        histogram.percentile(0.5) * 1e3,
+        histogram.percentile(0.99) * 1e3,
+        histogram.max * 1e3,
+        histogram.maxFrame
+    );
+}
+
+// Re-runs a capture recorded with IGFX_CAPTURE through the renderer without
+// the user library, so render cost can be measured on its own and compared
+// across engine builds (pass a csv path to keep per-frame times). Textures
+// loaded from files are loaded again by path, run it from the directory
+// the app ran in.
+int main(int argc, char** argv) {
+    if (argc < 2) std::fatal("usage: replay <capture> [times.csv]");
+    if (getenv("IGFX_CAPTURE") != nullptr) std::fatal("unset IGFX_CAPTURE before replaying");
+
+    FILE* file = fopen(argv[1], "rb");
+    if (file == nullptr) std::fatal("failed to open capture '{}'", argv[1]);
+    defer { fclose(file); };
+
+    capture::Header header;
+    if (
+        fread(&header, sizeof(header), 1, file) != 1
+        || __builtin_memcmp(header.magic, capture::magic, sizeof(capture::magic)) != 0
+    ) std::fatal("'{}' is not an igfx capture", argv[1]);
+
+    if (
+        header.version != capture::version
+        || header.spriteCommandSize != sizeof(graphics::SpriteCommand)
+        || header.spriteInfoSize != sizeof(graphics::SpriteInfo)
+    ) std::fatal("capture version {} is not supported by this build", header.version);
+
+    FILE* csv = nullptr;
+    if (argc > 2) {
+        csv = fopen(argv[2], "w");
+        if (csv == nullptr) std::fatal("failed to open '{}'", argv[2]);
+        fprintf(csv, "frame,sprites,user_ms,render_ms\n");
+    }
+
+    igfx::Config config;
+    config.width = header.width;
+    config.height = header.height;
+    config.title = "igfx replay";
+
+    engine::init(config);
+    defer { engine::deinit(); };
+
+    capture::FrameRecord record;
+    while (fread(&record, sizeof(record), 1, file) == 1) {
+        if (record.spriteCount > graphics::SpriteList::capacity) {
+            std::fatal("frame {} has too many sprites", record.index);
+        }
+
+        rebuild(file, record);
+
+        Frame* frame = engine::beginFrame(record.deltaTime);
+        graphics::SpriteList& sprites = graphics::spriteLists[frame->index];
+
+        sprites.count = fread(
+            sprites.commands,
+            sizeof(graphics::SpriteCommand),
+            record.spriteCount,
+            file
+        );
+        engine::endFrame(frame);
+
+        if (sprites.count != record.spriteCount) {
+            std::warn("capture truncated at frame {}", record.index);
+            break;
+        }
+
+        if (window::shouldClose()) break;
+
+        f64 start = timer::now();
+        engine::render();
+        f64 renderTime = timer::now() - start;
+
+        userTimes.add(record.index, record.userTime);
+        renderTimes.add(record.index, renderTime);
+
+        if (csv != nullptr) {
+            fprintf(
+                csv,
+                "%u,%u,%.4f,%.4f\n",
+                record.index,
+                record.spriteCount,
+                record.userTime * 1e3,
+                renderTime * 1e3
+            );
+        }
+    }
+
+    if (csv != nullptr) fclose(csv);
+
+    printf("%u frames replayed\n", renderTimes.count);
+    report("user", userTimes);
+    report("render", renderTimes);
+}
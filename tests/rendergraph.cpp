@@ -0,0 +1,144 @@
+#include "core/rendergraph.h"
+
+#include <stdio.h>
+
+using namespace igfx;
+using namespace igfx::graphics;
+
+// Culling, memory aliasing and barrier planning of the render graph, the
+// steps of `compile` that don't need a device.
+
+u32 failures = 0;
+
+void check(bool condition, u8 const* what) {
+    if (condition) return;
+
+    fprintf(stderr, "FAIL: %s\n", what);
+    failures++;
+}
+
+bool barrier(
+    RenderGraph const& graph,
+    u32 b,
+    ImageHandle image,
+    Access src,
+    Access dst,
+    bool discard
+) {
+    RenderGraph::Barrier const& barrier = graph.barriers[b];
+    return barrier.image == image.index
+        && barrier.src == src
+        && barrier.dst == dst
+        && barrier.discard == discard;
+}
+
+RenderGraph graph;
+
+int main() {
+    graph.reset();
+
+    ImageDesc desc {
+        .format = VK_FORMAT_B8G8R8A8_UNORM,
+        .extent = {64, 64},
+        .usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+    };
+
+    ImageHandle swapchain = graph.importImage(desc, Access::None, Access::Present, true);
+    ImageHandle a = graph.createImage(desc);
+    ImageHandle b = graph.createImage(desc);
+    ImageHandle c = graph.createImage(desc);
+    ImageHandle unused = graph.createImage(desc);
+
+    // a: 0..2, b: 2..3, c: 3..4. a and b overlap in pass 2, c starts after
+    // a's last use and takes its memory. Pass 1 writes an image nobody
+    // reads.
+    graph.addPass("a", nullptr, nullptr).color(a, VK_ATTACHMENT_LOAD_OP_CLEAR);
+    graph.addPass("unreachable", nullptr, nullptr).color(unused, VK_ATTACHMENT_LOAD_OP_CLEAR);
+
+    Pass& passB = graph.addPass("b", nullptr, nullptr);
+    passB.read(a, Access::ShaderRead);
+    passB.color(b, VK_ATTACHMENT_LOAD_OP_CLEAR);
+
+    Pass& passC = graph.addPass("c", nullptr, nullptr);
+    passC.read(b, Access::ShaderRead);
+    passC.color(c, VK_ATTACHMENT_LOAD_OP_CLEAR);
+
+    Pass& compose = graph.addPass("compose", nullptr, nullptr);
+    compose.read(c, Access::ShaderRead);
+    compose.color(swapchain, VK_ATTACHMENT_LOAD_OP_CLEAR);
+
+    VkMemoryRequirements requirements[RenderGraph::maxImages] = {};
+    requirements[a.index] = {.size = 4096, .alignment = 256, .memoryTypeBits = 0x3};
+    requirements[b.index] = {.size = 4096, .alignment = 256, .memoryTypeBits = 0x3};
+    requirements[c.index] = {.size = 8192, .alignment = 256, .memoryTypeBits = 0x2};
+    requirements[unused.index] = {.size = 4096, .alignment = 256, .memoryTypeBits = 0x3};
+
+    graph.cull();
+    graph.assignSlots(requirements);
+    graph.planBarriers();
+
+    check(
+        graph.alive[0] && graph.alive[2] && graph.alive[3] && graph.alive[4],
+        "a contributing pass was culled"
+    );
+    check(!graph.alive[1], "the unreachable pass was not culled");
+
+    check(graph.slotCount == 2, "expected 2 memory slots for 3 live transient images");
+    check(graph.images[a.index].memorySlot == 0, "a is not in slot 0");
+    check(graph.images[b.index].memorySlot == 1, "b overlaps a but does not get its own slot");
+    check(graph.images[c.index].memorySlot == 0, "c does not reuse a's slot");
+    check(graph.images[c.index].previous == a.index, "c does not follow a in its slot");
+    check(graph.images[unused.index].memorySlot == ImageHandle::invalid, "the culled image got memory");
+    check(graph.slots[0].size == 8192, "slot 0 is not sized for its largest occupant");
+    check(graph.slots[0].memoryTypeBits == 0x2, "slot 0 does not fit every occupant's memory types");
+
+    u32 const* offsets = graph.barrierOffsets;
+    check(offsets[1] - offsets[0] == 1, "pass a needs one barrier");
+    check(offsets[2] - offsets[1] == 0, "the culled pass has barriers");
+    check(offsets[3] - offsets[2] == 2, "pass b needs two barriers");
+    check(offsets[4] - offsets[3] == 2, "pass c needs two barriers");
+    check(offsets[5] - offsets[4] == 2, "pass compose needs two barriers");
+    check(offsets[6] - offsets[5] == 1, "the final batch needs one barrier");
+
+    if (failures > 0) return 1;
+
+    // The first occupant of a slot follows the last one from the previous
+    // frame, an aliased one follows the previous occupant.
+    check(
+        barrier(graph, offsets[0], a, Access::ShaderRead, Access::ColorAttachment, true),
+        "a does not wait for the previous frame's c"
+    );
+    check(
+        barrier(graph, offsets[2], a, Access::ColorAttachment, Access::ShaderRead, false),
+        "a is not made readable for b"
+    );
+    check(
+        barrier(graph, offsets[2] + 1, b, Access::ShaderRead, Access::ColorAttachment, true),
+        "b does not wait for the previous frame's b"
+    );
+    check(
+        barrier(graph, offsets[3], b, Access::ColorAttachment, Access::ShaderRead, false),
+        "b is not made readable for c"
+    );
+    check(
+        barrier(graph, offsets[3] + 1, c, Access::ShaderRead, Access::ColorAttachment, true),
+        "c does not wait for a's reads"
+    );
+    check(
+        barrier(graph, offsets[4], c, Access::ColorAttachment, Access::ShaderRead, false),
+        "c is not made readable for compose"
+    );
+    check(
+        barrier(graph, offsets[4] + 1, swapchain, Access::None, Access::ColorAttachment, true),
+        "the swapchain image is not acquired"
+    );
+    check(
+        barrier(graph, offsets[5], swapchain, Access::ColorAttachment, Access::Present, false),
+        "the swapchain image is not presented"
+    );
+
+    if (failures > 0) return 1;
+
+    printf("rendergraph: ok\n");
+    return 0;
+}
@@ -0,0 +1,108 @@
+#include "igfx/graphics.h"
+#include "core/software.h"
+#include "core/sprites.h"
+#include "core/jobs.h"
+
+#include <std/alloc.h>
+
+#include <stdio.h>
+
+using namespace igfx;
+
+// The software backend bins sprites per tile and rasterizes tiles on the
+// job threads, the framebuffer must not depend on how many there are.
+
+u32 failures = 0;
+
+void check(bool condition, u8 const* what) {
+    if (condition) return;
+
+    fprintf(stderr, "FAIL: %s\n", what);
+    failures++;
+}
+
+// Framebuffer size not a multiple of the tile size, so edge tiles are
+// partial.
+constexpr u32 width = 200;
+constexpr u32 height = 150;
+
+Sprite checker;
+Sprite quadrants;
+
+// Textured, tinted, rotated, flipped and blended sprites overlapping tile
+// boundaries.
+void scene(graphics::SpriteList* list) {
+    list->clear();
+
+    auto push = [&](Sprite sprite, vec2 position, vec2 scale, f32 rotation, BlendMode blend) {
+        list->push({
+            .sprite = sprite.index,
+            .position = position,
+            .scale = scale,
+            .rotation = rotation,
+            .blend = blend,
+            .color = 0xffffffff,
+        });
+    };
+
+    push({0}, {10.0f, 10.0f}, {180.0f, 130.0f}, 0.0f, BlendMode::Alpha);
+    push(checker, {-20.0f, 30.0f}, {6.0f, 6.0f}, 0.0f, BlendMode::Alpha);
+    push(checker, {70.0f, 20.0f}, {5.0f, 4.0f}, 0.6f, BlendMode::Alpha);
+    push(checker, {150.0f, 110.0f}, {-3.0f, 3.0f}, 0.0f, BlendMode::Additive);
+    push(quadrants, {40.0f, 60.0f}, {30.0f, 30.0f}, -1.1f, BlendMode::Multiply);
+    push(quadrants, {0.0f, 0.0f}, {50.0f, 50.0f}, 0.0f, BlendMode::Alpha);
+}
+
+std::Buf<u32> render(u32 workers) {
+    jobs::init(workers);
+    defer { jobs::deinit(); };
+
+    graphics::SpriteList* list = new graphics::SpriteList();
+    defer { delete list; };
+
+    scene(list);
+    software::render(list->slice());
+
+    auto pixels = std::alloc<u32>(width * height);
+    __builtin_memcpy(pixels.ptr, software::framebuffer.pixels.ptr, pixels.len * sizeof(u32));
+    return pixels;
+}
+
+int main() {
+    u32 checkerPixels[8 * 8];
+    for (u32 y = 0; y < 8; y++) {
+        for (u32 x = 0; x < 8; x++) {
+            checkerPixels[y * 8 + x] = ((x ^ y) & 1) ? 0xc0ff8020 : 0x80204080;
+        }
+    }
+    checker = createSprite({8, 8, checkerPixels});
+
+    u32 const quadrantPixels[4] = {0xff0000ff, 0xff00ff00, 0xffff0000, 0xffffffff};
+    quadrants = createSprite({2, 2, quadrantPixels});
+
+    software::init(width, height);
+    defer { software::deinit(); };
+
+    auto one = render(1);
+    defer { std::free(one); };
+
+    auto many = render(8);
+    defer { std::free(many); };
+
+    check(
+        __builtin_memcmp(one.ptr, many.ptr, one.len * sizeof(u32)) == 0,
+        "framebuffers differ between 1 and 8 workers"
+    );
+
+    // The last sprite covers (0, 0) to (100, 100) with the 2x2 texture
+    // unfiltered, each quadrant is one texel.
+    check(one[25 * width + 25] == 0xff0000ff, "top left quadrant is not the first texel");
+    check(one[25 * width + 75] == 0xff00ff00, "top right quadrant is not the second texel");
+    check(one[75 * width + 25] == 0xffff0000, "bottom left quadrant is not the third texel");
+    check(one[75 * width + 75] == 0xffffffff, "bottom right quadrant is not the fourth texel");
+
+    if (failures > 0) return 1;
+
+    printf("software: ok\n");
+    return 0;
+}